@@ -0,0 +1,224 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFile>
+#include <QSysInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QTextStream>
+#include <QThread>
+#include <Benchmark.hpp>
+#include <cmath>
+#include <limits>
+
+namespace {
+	struct Registration {
+		QString name;
+		Bench::Function function;
+		QVector<qint64> arguments;
+	};
+
+	QList<Registration>& registry(){
+		static QList<Registration> benchmarks;
+		return benchmarks;
+	}
+
+	struct CheckRegistration {
+		QString name;
+		Bench::CheckFunction function;
+	};
+
+	QList<CheckRegistration>& checkRegistry(){
+		static QList<CheckRegistration> checks;
+		return checks;
+	}
+
+	/** Number of failures described for each check, the others are only counted. */
+	const int maxMessages = 10;
+
+	/** Run the checks and print their outcome.
+	 @return The number of failed checks.
+	 */
+	int runChecks(const QRegularExpression& filter, QTextStream& out){
+		int failed = 0;
+		for(const auto& registration: checkRegistry()){
+			if(!filter.match(registration.name).hasMatch()) continue;
+			Bench::Check check;
+			registration.function(check);
+			out << qSetFieldWidth(48) << left << registration.name << qSetFieldWidth(0)
+			<< (check.getFailures() > 0 ? "FAILED" : "OK") << "\t" << check.getComparisons() << " comparisons, "
+			<< check.getFailures() << " failures, worst difference " << check.getWorstRatio() << " of the tolerance" << endl;
+			for(const auto& message: check.getMessages()) out << "    " << message << endl;
+			if(check.getFailures() > 0) ++failed;
+		}
+		out << (failed > 0 ? QString::number(failed) + " checks failed" : QString("All checks passed")) << endl;
+		return failed;
+	}
+
+	/** Measurement of a benchmark. */
+	struct Result {
+		QString name;
+		qint64 iterations;
+		double seconds;
+		qint64 items;
+		qint64 bytes;
+		QString label;
+	};
+
+	/** Run a benchmark growing the number of iterations until the measurement lasts at least minTime seconds. */
+	Result measure(const Registration& benchmark, double minTime){
+		qint64 iterations = 1;
+		Bench::State state(iterations, benchmark.arguments);
+		while(true){
+			state = Bench::State(iterations, benchmark.arguments);
+			benchmark.function(state);
+			if(state.getElapsed() >= minTime || iterations >= 1000000000) break;
+			double factor = state.getElapsed() > 0.0 ? 1.4 * minTime / state.getElapsed() : 10.0;
+			iterations = std::max(iterations + 1, qint64(iterations * std::min(factor, 10.0)));
+		}
+		return {benchmark.name, state.getIterations(), state.getElapsed(),
+			state.getItemsProcessed(), state.getBytesProcessed(), state.getLabel()};
+	}
+
+	QJsonObject toJson(const Result& result){
+		QJsonObject object{
+			{"name", result.name},
+			{"run_name", result.name},
+			{"run_type", "iteration"},
+			{"iterations", result.iterations},
+			{"real_time", result.seconds / result.iterations * 1e9},
+			{"cpu_time", result.seconds / result.iterations * 1e9},
+			{"time_unit", "ns"}
+		};
+		if(result.items > 0) object.insert("items_per_second", result.items / result.seconds);
+		if(result.bytes > 0) object.insert("bytes_per_second", result.bytes / result.seconds);
+		if(!result.label.isEmpty()) object.insert("label", result.label);
+		return object;
+	}
+
+	QJsonObject context(){
+		return {
+			{"date", QDateTime::currentDateTime().toString(Qt::ISODate)},
+			{"host_name", QSysInfo::machineHostName()},
+			{"executable", QCoreApplication::applicationFilePath()},
+			{"num_cpus", QThread::idealThreadCount()},
+#ifdef NDEBUG
+			{"library_build_type", "release"}
+#else
+			{"library_build_type", "debug"}
+#endif
+		};
+	}
+}
+
+int Bench::registerBenchmark(const QString& name, Function function){
+	registry() << Registration({name, function, QVector<qint64>()});
+	return registry().size();
+}
+
+int Bench::registerBenchmark(const QString& name, Function function, const QVector<QVector<qint64>>& arguments){
+	for(const auto& instance: arguments){
+		QString fullName = name;
+		for(const auto& argument: instance) fullName += "/" + QString::number(argument);
+		registry() << Registration({fullName, function, instance});
+	}
+	return registry().size();
+}
+
+int Bench::registerCheck(const QString& name, CheckFunction function){
+	checkRegistry() << CheckRegistration({name, function});
+	return checkRegistry().size();
+}
+
+void Bench::Check::fail(const QString& message){
+	if(++failures <= maxMessages) messages << message;
+}
+
+bool Bench::Check::expectNear(double value, double reference, double relative, double absolute, const QString& context){
+	++comparisons;
+	if(std::isnan(value) && std::isnan(reference)) return true;
+	const double difference = std::abs(value - reference);
+	const double tolerance = relative * std::abs(reference) + absolute;
+	// Also false for NaN values, which fail
+	if(difference <= tolerance){
+		if(tolerance > 0.0) worstRatio = std::max(worstRatio, difference / tolerance);
+		return true;
+	}
+	worstRatio = std::max(worstRatio, tolerance > 0.0 ? difference / tolerance : std::numeric_limits<double>::infinity());
+	fail(QString("%1: %2 instead of %3 (difference %4, tolerance %5)").arg(context).arg(value, 0, 'g', 17)
+		 .arg(reference, 0, 'g', 17).arg(difference, 0, 'g', 3).arg(tolerance, 0, 'g', 3));
+	return false;
+}
+
+bool Bench::Check::expect(bool condition, const QString& context){
+	++comparisons;
+	if(!condition) fail(context);
+	return condition;
+}
+
+int Bench::runAll(int argc, char* argv[]){
+	QCoreApplication app(argc, argv);
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Performance suite of the UMF and AA libraries.");
+	parser.addHelpOption();
+	parser.addPositionalArgument("filter", "Regular expression selecting the benchmarks (or the checks) to be run.", "[filter]");
+	QCommandLineOption formatOption("format", "Format of the standard output: console or json.", "format", "console");
+	parser.addOption(formatOption);
+	QCommandLineOption outOption("out", "Also write the results in JSON format to the given file.", "file");
+	parser.addOption(outOption);
+	QCommandLineOption minTimeOption("min-time", "Minimum duration of each measurement in seconds.", "seconds", "0.5");
+	parser.addOption(minTimeOption);
+	QCommandLineOption listOption("list", "List the benchmarks without running them.");
+	parser.addOption(listOption);
+	QCommandLineOption checkOption("check", "Run the accuracy checks instead of the benchmarks; the exit code is nonzero if any fails.");
+	parser.addOption(checkOption);
+	parser.process(app);
+	const auto arguments = parser.positionalArguments();
+	QRegularExpression filter(arguments.isEmpty() ? QString() : arguments.first());
+	const bool json = parser.value(formatOption) == "json";
+	const double minTime = std::max(0.0, parser.value(minTimeOption).toDouble());
+	QTextStream out(stdout);
+	if(parser.isSet(listOption)){
+		if(parser.isSet(checkOption)){
+			for(const auto& check: checkRegistry())
+				if(filter.match(check.name).hasMatch()) out << check.name << endl;
+			return 0;
+		}
+		for(const auto& benchmark: registry())
+			if(filter.match(benchmark.name).hasMatch()) out << benchmark.name << endl;
+		return 0;
+	}
+	if(parser.isSet(checkOption))
+		return runChecks(filter, out) > 0 ? 1 : 0;
+	if(!json){
+		out << qSetFieldWidth(48) << left << "Benchmark" << qSetFieldWidth(14) << right
+		<< "Time/iter(ns)" << "Iterations" << "Items/s" << qSetFieldWidth(0) << endl;
+	}
+	QJsonArray results;
+	for(const auto& benchmark: registry()){
+		if(!filter.match(benchmark.name).hasMatch()) continue;
+		const auto result = measure(benchmark, minTime);
+		results << toJson(result);
+		if(json) continue;
+		out << qSetFieldWidth(48) << left << result.name << qSetFieldWidth(14) << right
+		<< result.seconds / result.iterations * 1e9 << result.iterations
+		<< (result.items > 0 ? QString::number(result.items / result.seconds, 'g', 4) : QString("-"))
+		<< qSetFieldWidth(0) << " " << result.label << endl;
+	}
+	const QJsonDocument report(QJsonObject{{"context", context()}, {"benchmarks", results}});
+	if(json) out << report.toJson();
+	if(parser.isSet(outOption)){
+		QFile file(parser.value(outOption));
+		if(!file.open(QFile::WriteOnly) || file.write(report.toJson()) < 0){
+			QTextStream(stderr) << "Unable to write " << parser.value(outOption) << endl;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+int main(int argc, char* argv[]){
+	return Bench::runAll(argc, argv);
+}
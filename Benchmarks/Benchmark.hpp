@@ -0,0 +1,155 @@
+#ifndef Benchmark_hpp
+#define Benchmark_hpp
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <functional>
+
+namespace Bench {
+	class State;
+	class Check;
+
+	/** Signature of a benchmark function. */
+	typedef std::function<void(State&)> Function;
+
+	/** Signature of a check function. */
+	typedef std::function<void(Check&)> CheckFunction;
+
+	/** Register a benchmark; used by the BENCHMARK macro. */
+	int registerBenchmark(const QString& name, Function function);
+
+	/** Register a benchmark once for each set of arguments; used by the BENCHMARK_ARGS macro.
+	 Each instance is named after the arguments (e.g. name/8192/10), which are
+	 available to the benchmark through State::range.
+	 */
+	int registerBenchmark(const QString& name, Function function, const QVector<QVector<qint64>>& arguments);
+
+	/** Register a check; used by the CHECK macro. */
+	int registerCheck(const QString& name, CheckFunction function);
+
+	/** Run every registered benchmark and print the results.
+	 The results are printed as a table or in JSON format, with the same layout
+	 used by Google Benchmark so that the existing tools can compare two runs.
+	 With --check the checks are run instead, and the exit code is nonzero if any fails.
+	 Run with --help for the available options.
+	 */
+	int runAll(int argc, char* argv[]);
+}
+
+/** State of a running benchmark.
+ The benchmark function must contain exactly one loop of the form
+ @code
+ for (auto _ : state) { ... }
+ @endcode
+ whose body is the code to be measured. The number of iterations is chosen
+ by the runner, so that each measurement lasts long enough to be reliable.
+ */
+class Bench::State {
+
+public:
+	class Iterator {
+		State* state;
+		qint64 remaining;
+	public:
+		Iterator(State* state, qint64 remaining): state(state), remaining(remaining) {};
+		bool operator!=(const Iterator&) {
+			if (remaining > 0) return true;
+			state->stopTiming();
+			return false;
+		};
+		Iterator& operator++() {--remaining; return *this;};
+		int operator*() const {return 0;};
+	};
+
+	explicit State(qint64 iterations, const QVector<qint64>& arguments = QVector<qint64>()):
+	iterations(iterations), arguments(arguments) {};
+
+	Iterator begin() {startTiming(); return Iterator(this, iterations);};
+	Iterator end() {return Iterator(this, 0);};
+
+	/** Exclude the following code from the measurement (e.g. per-iteration setup). */
+	void pauseTiming() {stopTiming();};
+	/** Include the following code in the measurement again. */
+	void resumeTiming() {startTiming();};
+
+	/** Set the number of items (records, pairs, ...) processed overall, used to compute the throughput. */
+	void setItemsProcessed(qint64 items) {itemsProcessed = items;};
+	/** Set the number of bytes processed overall, used to compute the bandwidth. */
+	void setBytesProcessed(qint64 bytes) {bytesProcessed = bytes;};
+	/** Attach a free text label to the result. */
+	void setLabel(const QString& text) {label = text;};
+
+	/** Argument of the benchmark instance, e.g. the record length. */
+	qint64 range(int index) const {return arguments.value(index);};
+
+	qint64 getIterations() const {return iterations;};
+	qint64 getItemsProcessed() const {return itemsProcessed;};
+	qint64 getBytesProcessed() const {return bytesProcessed;};
+	QString getLabel() const {return label;};
+	/** Measured time in seconds. */
+	double getElapsed() const {return elapsed * 1e-9;};
+
+private:
+	void startTiming() {timer.start();};
+	void stopTiming() {if (timer.isValid()) {elapsed += timer.nsecsElapsed(); timer.invalidate();}};
+
+	qint64 iterations;
+	QVector<qint64> arguments;
+	qint64 itemsProcessed = 0;
+	qint64 bytesProcessed = 0;
+	qint64 elapsed = 0;
+	QString label;
+	QElapsedTimer timer;
+};
+
+/** Accuracy check of an implementation against a reference (e.g. the previous implementation).
+ The check function compares as many values as needed; each comparison out of its tolerance is a
+ failure, described by the given context.
+ */
+class Bench::Check {
+
+public:
+	/** Whether |value-reference| <= relative*|reference| + absolute; NaN values fail unless both are NaN. */
+	bool expectNear(double value, double reference, double relative, double absolute, const QString& context);
+
+	/** Whether the condition holds. */
+	bool expect(bool condition, const QString& context);
+
+	qint64 getComparisons() const {return comparisons;};
+	qint64 getFailures() const {return failures;};
+	/** Largest ratio of the difference to the tolerance, over the comparisons of expectNear. */
+	double getWorstRatio() const {return worstRatio;};
+	/** Descriptions of the first failures. */
+	QStringList getMessages() const {return messages;};
+
+private:
+	qint64 comparisons = 0;
+	qint64 failures = 0;
+	double worstRatio = 0.0;
+	QStringList messages;
+
+	void fail(const QString& message);
+};
+
+namespace Bench {
+	/** Prevent the compiler from optimizing away the computation of a value. */
+	template <typename T>
+	inline void doNotOptimize(const T& value){
+		asm volatile("" : : "g"(&value) : "memory");
+	}
+}
+
+#define BENCHMARK(function) \
+	static int function##_registration = Bench::registerBenchmark(#function, function);
+
+/** Register a benchmark for each list of arguments, e.g. BENCHMARK_ARGS(BM_Stage, {4096}, {8192}). */
+#define BENCHMARK_ARGS(function, ...) \
+	static int function##_registration = Bench::registerBenchmark(#function, function, {__VA_ARGS__});
+
+/** Register a check, run by cava-bench --check. */
+#define CHECK(function) \
+	static int function##_registration = Bench::registerCheck(#function, function);
+
+#endif /* Benchmark_hpp */
@@ -0,0 +1,96 @@
+#include <Benchmark.hpp>
+#include <SyntheticData.hpp>
+#include <AA/DatabaseFile.hpp>
+#include <QDataStream>
+#include <QDir>
+#include <QHash>
+#include <QTemporaryDir>
+
+namespace {
+	QTemporaryDir& folder(){
+		static QTemporaryDir dir;
+		return dir;
+	}
+
+	/** Database of synthetic files, in the binary format and as the stream of features of the previous versions. */
+	struct SyntheticDatabase {
+		QString binary, stream;
+		qint64 bytes = 0;
+	};
+
+	const SyntheticDatabase& syntheticDatabase(int files){
+		static QHash<int, SyntheticDatabase> databases;
+		if(!databases.contains(files)){
+			const auto features = Bench::syntheticFeatures(files);
+			SyntheticDatabase database;
+			database.binary = QDir(folder().path()).filePath(QString("%1.cavadb").arg(files));
+			database.stream = QDir(folder().path()).filePath(QString("%1.stream").arg(files));
+			AA::DatabaseFile::Contents contents;
+			for(int f = 0; f < files; ++f){
+				AA::DatabaseFile::File file;
+				file.Features = features[f].constData();
+				file.Size = features[f].size();
+				file.Summary = AA::FeaturesSummary::fromFeatures(features[f]);
+				file.Group = f / 10;
+				contents.Files << file;
+			}
+			AA::DatabaseFile::Curve curve;
+			curve.Coefficients = {5.0, 0.3, 0.1, 0.1};
+			curve.NumberFiles = files;
+			contents.Curves << curve << curve;
+			AA::DatabaseFile::save(database.binary, contents);
+			QFile output(database.stream);
+			output.open(QFile::WriteOnly);
+			QDataStream stream(&output);
+			stream << features;
+			database.bytes = output.size();
+			databases.insert(files, database);
+		}
+		return databases[files];
+	}
+}
+
+/** Previous loading: every feature is deserialized into the heap, and the summaries are computed again. */
+static void BM_DatabaseLoadStream(Bench::State& state){
+	const auto& database = syntheticDatabase(int(state.range(0)));
+	for(auto _ : state){
+		QFile input(database.stream);
+		input.open(QFile::ReadOnly);
+		QDataStream stream(&input);
+		QList<QVector<double>> features;
+		stream >> features;
+		QVector<AA::FeaturesSummary> summaries;
+		for(const auto& F: features) summaries << AA::FeaturesSummary::fromFeatures(F);
+		Bench::doNotOptimize(summaries);
+	}
+	state.setItemsProcessed(state.getIterations() * state.range(0));
+	state.setBytesProcessed(state.getIterations() * database.bytes);
+}
+BENCHMARK_ARGS(BM_DatabaseLoadStream, {1000}, {10000})
+
+/** Mapping of the binary database, followed by the reading of the stored summaries; the features are not touched. */
+static void BM_DatabaseLoadMapped(Bench::State& state){
+	const auto& database = syntheticDatabase(int(state.range(0)));
+	for(auto _ : state){
+		AA::DatabaseFile file;
+		file.open(database.binary);
+		QVector<AA::FeaturesSummary> summaries(file.getNumberFiles());
+		for(int k = 0; k < summaries.size(); ++k) summaries[k] = file.getSummary(k);
+		Bench::doNotOptimize(summaries);
+	}
+	state.setItemsProcessed(state.getIterations() * state.range(0));
+	state.setBytesProcessed(state.getIterations() * database.bytes);
+}
+BENCHMARK_ARGS(BM_DatabaseLoadMapped, {1000}, {10000})
+
+/** Mapping of the binary database only, which is independent of its size. */
+static void BM_DatabaseOpen(Bench::State& state){
+	const auto& database = syntheticDatabase(int(state.range(0)));
+	for(auto _ : state){
+		AA::DatabaseFile file;
+		file.open(database.binary);
+		Bench::doNotOptimize(file.getNumberFiles());
+	}
+	state.setItemsProcessed(state.getIterations());
+}
+BENCHMARK_ARGS(BM_DatabaseOpen, {1000}, {10000})
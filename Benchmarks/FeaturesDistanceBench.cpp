@@ -0,0 +1,104 @@
+#include <Benchmark.hpp>
+#include <SyntheticData.hpp>
+#include <AA/FeaturesDistance.hpp>
+#include <armadillo>
+#include <random>
+
+namespace {
+	const int numberSummaries = 1024;
+
+	/** Summaries with random means and covariances, some of which ill-conditioned once pooled. */
+	QVector<AA::FeaturesSummary> syntheticSummaries(){
+		QVector<AA::FeaturesSummary> summaries(numberSummaries);
+		std::mt19937 gen(3);
+		std::uniform_real_distribution<> uniform(0.0, 1.0);
+		for(auto& S: summaries){
+			S.Count = 1 + gen() % 500;
+			S.MeanX = 1.0 + 2.0 * uniform(gen);
+			S.MeanY = 1.0 + 2.0 * uniform(gen);
+			S.CovXX = 0.1 * uniform(gen);
+			S.CovYY = 0.1 * uniform(gen);
+			S.CovXY = (2.0 * uniform(gen) - 1.0) * sqrt(S.CovXX * S.CovYY);
+		}
+		return summaries;
+	}
+
+	/** Previous implementation of the distance, with general Armadillo matrices. */
+	double armadilloDistance(const AA::FeaturesSummary& A, const AA::FeaturesSummary& B){
+		const double maxCond = 0.1;
+		arma::mat CA = {{A.CovXX, A.CovXY}, {A.CovXY, A.CovYY}};
+		arma::mat CB = {{B.CovXX, B.CovXY}, {B.CovXY, B.CovYY}};
+		arma::mat C = (double(A.Count) * CA + double(B.Count) * CB) / double(A.Count + B.Count);
+		if(arma::rcond(C) < maxCond){
+			C.eye();
+		}
+		arma::rowvec m = {A.MeanX - B.MeanX, A.MeanY - B.MeanY};
+		return sqrt( arma::as_scalar(m * arma::inv(C) * m.t()) );
+	}
+
+	/** Compare the two implementations on every pair, to report the largest relative difference. */
+	QString accuracy(const QVector<AA::FeaturesSummary>& summaries){
+		double maxError = 0.0;
+		int fallbackMismatch = 0;
+		for(int i = 0; i < summaries.size(); ++i){
+			for(int j = i+1; j < summaries.size(); ++j){
+				const double reference = armadilloDistance(summaries[i], summaries[j]);
+				const double value = AA::FeaturesDistance::compute(summaries[i], summaries[j]);
+				const double error = std::abs(value - reference) / std::max(std::abs(reference), 1e-300);
+				// A condition number at the threshold may select the identity in only one of them
+				if(error > 1e-6) ++fallbackMismatch;
+				else maxError = std::max(maxError, error);
+			}
+		}
+		return QString("max rel. error %1, %2 threshold mismatches").arg(maxError).arg(fallbackMismatch);
+	}
+}
+
+static void BM_Distance2x2Armadillo(Bench::State& state){
+	const auto summaries = syntheticSummaries();
+	double sum = 0.0;
+	for(auto _ : state){
+		for(int k = 1; k < summaries.size(); ++k)
+			sum += armadilloDistance(summaries[k-1], summaries[k]);
+	}
+	Bench::doNotOptimize(sum);
+	state.setItemsProcessed(state.getIterations() * (summaries.size() - 1));
+}
+BENCHMARK(BM_Distance2x2Armadillo)
+
+static void BM_Distance2x2ClosedForm(Bench::State& state){
+	const auto summaries = syntheticSummaries();
+	double sum = 0.0;
+	for(auto _ : state){
+		for(int k = 1; k < summaries.size(); ++k)
+			sum += AA::FeaturesDistance::compute(summaries[k-1], summaries[k]);
+	}
+	Bench::doNotOptimize(sum);
+	state.setItemsProcessed(state.getIterations() * (summaries.size() - 1));
+	static const QString label = accuracy(summaries);
+	state.setLabel(label);
+}
+BENCHMARK(BM_Distance2x2ClosedForm)
+
+/** Distance between two files from their features, with the number of records per file as argument. */
+static void BM_FeaturesDistanceFeatures(Bench::State& state){
+	const auto features = Bench::syntheticFeatures(2, int(state.range(0)));
+	double sum = 0.0;
+	for(auto _ : state) sum += AA::FeaturesDistance::compute(features[0], features[1]);
+	Bench::doNotOptimize(sum);
+	state.setItemsProcessed(state.getIterations());
+}
+BENCHMARK_ARGS(BM_FeaturesDistanceFeatures, {100}, {1000}, {10000})
+
+/** Distance between two files from their summaries, in constant time. */
+static void BM_FeaturesDistanceSummaries(Bench::State& state){
+	const auto features = Bench::syntheticFeatures(2, int(state.range(0)));
+	const auto A = AA::FeaturesSummary::fromFeatures(features[0]);
+	const auto B = AA::FeaturesSummary::fromFeatures(features[1]);
+	double sum = 0.0;
+	for(auto _ : state) sum += AA::FeaturesDistance::compute(A, B);
+	Bench::doNotOptimize(sum);
+	state.setItemsProcessed(state.getIterations());
+}
+BENCHMARK_ARGS(BM_FeaturesDistanceSummaries, {100}, {10000})
+
@@ -0,0 +1,55 @@
+#include <Benchmark.hpp>
+#include <SyntheticData.hpp>
+#include <AA/FeaturesExtractor.hpp>
+#include <QFileInfo>
+
+/* End to end extraction of the features of a synthetic WAV file, as performed when
+ creating a database: open and map the file, then process every record.
+ The arguments are the record length and the duration of the file in seconds;
+ items are records. The features cache is disabled.
+ */
+
+namespace {
+	const int sampleRate = 44100;
+
+	void extract(Bench::State& state, int threads, int hopLength = 0){
+		const int recordLength = int(state.range(0));
+		const auto file = Bench::syntheticWavFiles(1, double(state.range(1)), sampleRate).first();
+		// The record length is the smallest power of two not below the ratio of the sample rate to the leakage
+		auto extractor = AA::FeaturesExtractor::create({
+			{"File", file},
+			{"NumberThreads", threads},
+			{"HopLength", hopLength},
+			{"MinimumFrequency", 500.0},
+			{"MaximumFrequency", 3500.0},
+			{"MaximumSpectrumLeakage", 1.01 * sampleRate / recordLength},
+			{"GaussianFilterWidth", 8}
+		});
+		qint64 records = 0;
+		for (auto _ : state){
+			extractor->run();
+			records += extractor->getOutTotalRecords();
+			Bench::doNotOptimize(extractor->getOutSummary());
+		}
+		state.setItemsProcessed(records);
+		state.setBytesProcessed(state.getIterations() * QFileInfo(file).size());
+		state.setLabel(QString("%1 records of %2 samples").arg(extractor->getOutTotalRecords()).arg(extractor->getOutRecordLength()));
+	}
+}
+
+static void BM_FeaturesExtractor(Bench::State& state){
+	extract(state, 1);
+}
+BENCHMARK_ARGS(BM_FeaturesExtractor, {4096, 10}, {8192, 10}, {16384, 10}, {8192, 60})
+
+/** Records of a single file split among all the available cores. */
+static void BM_FeaturesExtractorParallel(Bench::State& state){
+	extract(state, 0);
+}
+BENCHMARK_ARGS(BM_FeaturesExtractorParallel, {8192, 60}, {8192, 300})
+
+/** Overlapping records, with the hop length as third argument (half and a quarter of the record). */
+static void BM_FeaturesExtractorOverlap(Bench::State& state){
+	extract(state, 1, int(state.range(2)));
+}
+BENCHMARK_ARGS(BM_FeaturesExtractorOverlap, {8192, 10, 4096}, {8192, 10, 2048})
@@ -0,0 +1,100 @@
+#include <Benchmark.hpp>
+#include <SyntheticData.hpp>
+#include <AA/FeaturesDistance.hpp>
+#include <AA/MatchingService.hpp>
+#include <AA/PairwiseDistances.hpp>
+#include <UMF/ComputeHistogram.hpp>
+#include <QThread>
+#include <random>
+
+namespace {
+	const int filesPerGroup = 10;
+
+	QVector<int> syntheticGroups(int files){
+		QVector<int> groups(files);
+		for(int f = 0; f < files; ++f) groups[f] = f / filesPerGroup;
+		return groups;
+	}
+
+	/** Previous implementation: one FeaturesDistance instance per pair, then the histogram of the distances.
+	 Every instance computes the statistics of both its files again.
+	 The instances are run directly, so the cost of the connections among them is not even included.
+	 */
+	void pairObjects(Bench::State& state, int files){
+		const auto features = Bench::syntheticFeatures(files);
+		qint64 pairs = 0;
+		for(auto _ : state){
+			QVector<double> distances;
+			for(int i = 0; i < files; ++i){
+				for(int j = i+1; j < files; ++j){
+					auto distanceCalculator = AA::FeaturesDistance::create();
+					distanceCalculator->setInFeatures(features[i]);
+					distanceCalculator->setInFeatures(features[j]);
+					distanceCalculator->run();
+					distances << distanceCalculator->getOutDistance();
+				}
+			}
+			pairs = distances.size();
+			auto histCompute = UMF::ComputeHistogram::create({{"Values", QVariant::fromValue(distances)}});
+			histCompute->run();
+			Bench::doNotOptimize(histCompute->getOutHistY());
+		}
+		state.setItemsProcessed(state.getIterations() * pairs);
+	}
+
+	void pairwiseEngine(Bench::State& state, int files, int threads){
+		auto histCompute = AA::PairwiseDistances::create({
+			{"Pairs", AA::PairwiseDistances::all},
+			{"NumberThreads", threads}
+		});
+		QVector<AA::FeaturesSummary> summaries;
+		for(const auto& features: Bench::syntheticFeatures(files)) summaries << AA::FeaturesSummary::fromFeatures(features);
+		const auto groups = syntheticGroups(files);
+		for(auto _ : state){
+			histCompute->setInSummaries(summaries);
+			histCompute->setInGroups(groups);
+			histCompute->run();
+			Bench::doNotOptimize(histCompute->getOutHistY());
+		}
+		state.setItemsProcessed(state.getIterations() * histCompute->getOutNumberDistances());
+	}
+
+	/** Score a number of unknown files one by one against a database; items are the unknown files. */
+	void matchingService(Bench::State& state, int files, int unknowns, int threads){
+		QVector<AA::FeaturesSummary> database, queries;
+		for(const auto& features: Bench::syntheticFeatures(files + unknowns))
+			(database.size() < files ? database : queries) << AA::FeaturesSummary::fromFeatures(features);
+		AA::MatchingService::Parameters parameters;
+		parameters.NumberThreads = threads;
+		const AA::MatchingService service(database, {1.0, 0.6, 0.15, 0.4}, {1.0, 1.0, 0.2, 0.5}, parameters);
+		for(auto _ : state)
+			Bench::doNotOptimize(service.match(queries));
+		state.setItemsProcessed(state.getIterations() * unknowns);
+	}
+
+	int registerPairwise(){
+		for(int files: {100, 400}){
+			Bench::registerBenchmark(QString("BM_PairwiseDistanceObjects/files:%1").arg(files),
+									 [files](Bench::State& state){pairObjects(state, files);});
+			Bench::registerBenchmark(QString("BM_PairwiseDistances/files:%1/threads:1").arg(files),
+									 [files](Bench::State& state){pairwiseEngine(state, files, 1);});
+			Bench::registerBenchmark(QString("BM_PairwiseDistances/files:%1/threads:all").arg(files),
+									 [files](Bench::State& state){pairwiseEngine(state, files, 0);});
+		}
+		// Sizes only the engine can handle
+		Bench::registerBenchmark("BM_PairwiseDistances/files:5000/threads:all",
+								 [](Bench::State& state){pairwiseEngine(state, 5000, 0);});
+		// Unknown files scored one by one against a loaded database
+		for(int threads: {1, 0})
+			Bench::registerBenchmark(QString("BM_MatchingService/files:400/unknowns:1000/threads:%1").arg(threads ? QString::number(threads) : "all"),
+									 [threads](Bench::State& state){matchingService(state, 400, 1000, threads);});
+		// Scaling with the number of threads, up to the available cores
+		for(int threads = 2; threads <= QThread::idealThreadCount(); threads *= 2)
+			Bench::registerBenchmark(QString("BM_PairwiseDistances/files:5000/threads:%1").arg(threads),
+									 [threads](Bench::State& state){pairwiseEngine(state, 5000, threads);});
+		return 0;
+	}
+}
+
+static int BM_Pairwise_registration = registerPairwise();
+
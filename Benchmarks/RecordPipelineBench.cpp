@@ -0,0 +1,133 @@
+#include <Benchmark.hpp>
+#include <SyntheticData.hpp>
+#include <AA/RecordPipeline.hpp>
+#include <AA/StreamingExtractor.hpp>
+#include <algorithm>
+
+namespace {
+	const int sampleRate = 44100;
+	const int numberChannels = 2;
+	const int numberRecords = 16;
+
+	/** Interleaved stereo voice-like records. */
+	QVector<qint16> syntheticRecords(int recordLength){
+		return Bench::syntheticSignal(qint64(numberRecords) * recordLength, sampleRate, numberChannels, 42);
+	}
+
+	AA::RecordPipeline::Parameters pipelineParameters(int recordLength){
+		AA::RecordPipeline::Parameters P;
+		P.SampleRate = sampleRate;
+		P.RecordLength = recordLength;
+		P.NumberChannels = numberChannels;
+		P.MinimumFrequency = 500.0;
+		P.MaximumFrequency = 3500.0;
+		P.GaussianFilterWidth = 8;
+		return P;
+	}
+}
+
+/** Previous implementation: one QAlgorithm per stage, each allocating its output. */
+static void BM_RecordChainAlgorithms(Bench::State& state){
+	const int recordLength = int(state.range(0));
+	const auto records = syntheticRecords(recordLength);
+	const auto P = pipelineParameters(recordLength);
+	const int numSamplesPerRecord = recordLength * numberChannels;
+	auto channelsReduce = UMF::ReduceChannels::create({
+		{"NumberChannels", P.NumberChannels},
+		{"Operation", P.ChannelsOperation},
+		{"ChannelsArrangement", P.ChannelsArrangement}
+	});
+	auto windowing = UMF::Windowing::create({
+		{"Length", P.RecordLength},
+		{"Type", P.WindowingFunction}
+	});
+	auto gaussianFilter = UMF::GaussianFilter::create({
+		{"Radius", P.GaussianFilterWidth},
+		{"BorderType", P.ExtrapolationMethod}
+	});
+	auto spectrumMagnitude = UMF::SpectrumMagnitude::create();
+	auto backgroundRemove = UMF::SpectrumRemoveBackground::create({
+		{"NumberIterations", P.BackIterations},
+		{"Direction", P.BackDirection},
+		{"FilterOrder", P.BackFilterOrder},
+		{"Smoothing", P.BackSmoothing},
+		{"SmoothWindow", P.BackSmoothWindow},
+		{"Compton", P.BackCompton}
+	});
+	QVector<double> samples(numSamplesPerRecord);
+	int processed = 0;
+	for (auto _ : state){
+		auto samplesData = records.constData() + (processed % numberRecords) * numSamplesPerRecord;
+		std::transform(samplesData, samplesData + numSamplesPerRecord, samples.begin(), [](const auto& x){return double(x/double(0x7FFF));});
+		channelsReduce->setInSignal(samples);
+		channelsReduce->run();
+		windowing->getInput(channelsReduce);
+		windowing->run();
+		gaussianFilter->getInput(windowing);
+		gaussianFilter->run();
+		spectrumMagnitude->getInput(gaussianFilter);
+		spectrumMagnitude->run();
+		backgroundRemove->getInput(spectrumMagnitude);
+		backgroundRemove->run();
+		Bench::doNotOptimize(backgroundRemove->getOutSignal());
+		++processed;
+	}
+	state.setItemsProcessed(processed);
+	state.setLabel("records");
+}
+BENCHMARK_ARGS(BM_RecordChainAlgorithms, {4096}, {8192}, {16384})
+
+/** Fused chain working on preallocated buffers. */
+static void BM_RecordPipeline(Bench::State& state){
+	const int recordLength = int(state.range(0));
+	const auto records = syntheticRecords(recordLength);
+	const int numSamplesPerRecord = recordLength * numberChannels;
+	AA::RecordPipeline pipeline(pipelineParameters(recordLength));
+	double features[3];
+	int processed = 0;
+	for (auto _ : state){
+		pipeline.process(records.constData() + (processed % numberRecords) * numSamplesPerRecord, features);
+		Bench::doNotOptimize(features);
+		++processed;
+	}
+	state.setItemsProcessed(processed);
+	state.setLabel("records");
+}
+BENCHMARK_ARGS(BM_RecordPipeline, {4096}, {8192}, {16384})
+
+/** Fused chain computing the spectra of all the records of a batch together. */
+static void BM_RecordPipelineBatch(Bench::State& state){
+	const int recordLength = int(state.range(0));
+	const auto records = syntheticRecords(recordLength);
+	AA::RecordPipeline pipeline(pipelineParameters(recordLength));
+	QVector<double> features(3 * numberRecords);
+	for (auto _ : state){
+		pipeline.processBatch(records.constData(), numberRecords, features.data());
+		Bench::doNotOptimize(features);
+	}
+	state.setItemsProcessed(state.getIterations() * numberRecords);
+	state.setLabel("records");
+}
+BENCHMARK_ARGS(BM_RecordPipelineBatch, {4096}, {8192}, {16384})
+
+/** Records pushed to the streaming extractor in chunks of the given number of frames (second argument),
+ e.g. 882 frames for the 20 ms buffers of an audio callback, including the update of the running summary.
+ */
+static void BM_StreamingExtractor(Bench::State& state){
+	const int recordLength = int(state.range(0));
+	const int chunkSize = int(state.range(1)) * numberChannels;
+	const auto records = syntheticRecords(recordLength);
+	AA::StreamingExtractor streaming(pipelineParameters(recordLength));
+	QVector<double> features;
+	for (auto _ : state){
+		streaming.reset();
+		for (int offset = 0; offset < records.size(); offset += chunkSize){
+			features.clear();
+			streaming.push(records.constData() + offset, std::min(chunkSize, records.size() - offset), features);
+			Bench::doNotOptimize(streaming.getSummary());
+		}
+	}
+	state.setItemsProcessed(state.getIterations() * numberRecords);
+	state.setLabel("records");
+}
+BENCHMARK_ARGS(BM_StreamingExtractor, {8192, 64}, {8192, 882}, {8192, 8192})
@@ -0,0 +1,435 @@
+#include <Benchmark.hpp>
+#include <SyntheticData.hpp>
+#include <UMF/ComputeHistogram.hpp>
+#include <UMF/CurveNormalization.hpp>
+#include <UMF/HistogramAccumulator.hpp>
+#include <UMF/Evaluate1D.hpp>
+#include <UMF/FastMath.hpp>
+#include <UMF/RealFFT.hpp>
+#include <UMF/SignalProcessing.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#ifdef CAVA_WITH_ROOT
+#include <TSpectrum.h>
+#endif
+
+/* Microbenchmarks of the single UMF stages, run through their QAlgorithm interface
+ (i.e. including the copies of the inputs and the allocation of the outputs).
+ Record lengths are the ones selected by the default spectrum leakage for sample rates
+ between 44.1 and 192 kHz; items are the samples of the input signal.
+ */
+
+namespace {
+	const int sampleRate = 44100;
+	const int numberChannels = 2;
+
+	/** Interleaved stereo record, converted to double as done by the extractor. */
+	QVector<double> stereoRecord(int recordLength){
+		const auto samples = Bench::syntheticSignal(recordLength, sampleRate, numberChannels);
+		QVector<double> record(samples.size());
+		std::transform(samples.begin(), samples.end(), record.begin(), [](const auto& x){return double(x/double(0x7FFF));});
+		return record;
+	}
+
+	/** Windowed single channel record. */
+	QVector<double> monoRecord(int recordLength){
+		auto channelsReduce = UMF::ReduceChannels::create({{"NumberChannels", numberChannels}});
+		channelsReduce->setInSignal(stereoRecord(recordLength));
+		channelsReduce->run();
+		auto windowing = UMF::Windowing::create({{"Length", recordLength}});
+		windowing->getInput(channelsReduce);
+		windowing->run();
+		return windowing->getOutSignal();
+	}
+
+	/** Power spectrum of a record, with recordLength/2+1 elements. */
+	QVector<double> spectrum(int recordLength){
+		auto spectrumMagnitude = UMF::SpectrumMagnitude::create();
+		spectrumMagnitude->setInSignal(monoRecord(recordLength));
+		spectrumMagnitude->run();
+		return spectrumMagnitude->getOutSignal();
+	}
+
+	/** Run an algorithm on the same input over and over. */
+	template <typename Algorithm>
+	void runStage(Bench::State& state, Algorithm& algorithm, const QVector<double>& input){
+		for (auto _ : state){
+			algorithm->setInSignal(input);
+			algorithm->run();
+			Bench::doNotOptimize(algorithm->getOutSignal());
+		}
+		state.setItemsProcessed(state.getIterations() * input.size());
+		state.setBytesProcessed(state.getIterations() * input.size() * sizeof(double));
+	}
+
+	/** Histogram of the distances among files, with the shape of the actual ones. */
+	void distancesHistogram(int numberBins, QVector<double>& X, QVector<double>& Y){
+		auto evaluator = UMF::EvaluateGaussExp::create({{"Coefficients", QVariant::fromValue(QVector<double>({1.0, 0.6, 0.15, 0.4}))}});
+		const double step = 2.0 / numberBins;
+		X.resize(numberBins);
+		for (int k = 0; k < numberBins; ++k) X[k] = step * (k + 0.5);
+		evaluator->setInX(X);
+		evaluator->run();
+		Y = evaluator->getOutY();
+		std::mt19937 gen(11);
+		std::normal_distribution<> noise(1.0, 0.05);
+		for (auto& y: Y) y *= noise(gen);
+	}
+
+	/** Fit the histogram again and again; Y is consumed by the algorithm, so it is set at every iteration. */
+	template <typename Fitting>
+	void runFitting(Bench::State& state){
+		QVector<double> X, Y;
+		distancesHistogram(int(state.range(0)), X, Y);
+		auto fitting = Fitting::create();
+		for (auto _ : state){
+			fitting->setInX(X);
+			fitting->setInY(Y);
+			fitting->run();
+			Bench::doNotOptimize(fitting->getOutCoefficients());
+		}
+		state.setItemsProcessed(state.getIterations());
+		state.setLabel(QString("avg rel. error %1").arg(fitting->getOutAvgRelError()));
+	}
+
+	/** Points where the curves are evaluated, as many as the argument, over the range of the distances. */
+	QVector<double> curvePoints(Bench::State& state){
+		QVector<double> X(int(state.range(0)));
+		for (int k = 0; k < X.size(); ++k) X[k] = 2.0 * (k + 0.5) / X.size();
+		return X;
+	}
+
+	/** Evaluate a curve by its kernel. */
+	template <typename Evaluator>
+	void runEvaluation(Bench::State& state, const QVector<double>& coefficients){
+		const auto X = curvePoints(state);
+		auto evaluator = Evaluator::create({{"Coefficients", QVariant::fromValue(coefficients)}});
+		for (auto _ : state){
+			evaluator->setInX(X);
+			evaluator->run();
+			Bench::doNotOptimize(evaluator->getOutY());
+		}
+		state.setItemsProcessed(state.getIterations() * X.size());
+	}
+
+	/** Compare the kernel of a curve with its ALGLIB evaluation, for every combination of mu, sigma and tau,
+	 from 10 sigmas below the mean (or 0) to 6 sigmas above it (or 2, the range of the distances).
+	 @param[in] absolute Absolute tolerance at x, besides the relative one.
+	 */
+	template <typename Evaluator, typename Absolute>
+	void checkEvaluation(Bench::Check& check, double relative, Absolute absolute){
+		const double nu = 1.3;
+		for (double mu: {0.3, 0.8, 1.5})
+			for (double sigma: {0.05, 0.2, 0.6})
+				for (double tau: {0.1, 0.4, 2.0}){
+					const QVector<double> coefficients({nu, mu, sigma, tau});
+					const double left = std::min(0.0, mu - 10.0 * sigma), right = std::max(2.0, mu + 6.0 * sigma);
+					QVector<double> X(2001);
+					for (int k = 0; k < X.size(); ++k) X[k] = left + (right - left) * k / (X.size() - 1);
+					auto evaluator = Evaluator::create({{"Coefficients", QVariant::fromValue(coefficients)}});
+					evaluator->setInX(X);
+					evaluator->run();
+					const auto Y = evaluator->getOutY();
+					alglib::real_1d_array c, x;
+					c.setcontent(coefficients.size(), coefficients.constData());
+					for (int k = 0; k < X.size(); ++k){
+						double y;
+						x.setcontent(1, &X[k]);
+						evaluator->getInternalFunc()(c, x, y, Q_NULLPTR);
+						check.expectNear(Y[k], y, relative, absolute(coefficients, X[k]),
+										 QString("mu %1, sigma %2, tau %3, x %4").arg(mu).arg(sigma).arg(tau).arg(X[k]));
+					}
+				}
+	}
+	/** Evaluate a curve point by point through ALGLIB, the previous implementation. */
+	template <typename Evaluator>
+	void runEvaluationAlglib(Bench::State& state, const QVector<double>& coefficients){
+		const auto X = curvePoints(state);
+		auto evaluator = Evaluator::create();
+		alglib::real_1d_array c, x;
+		c.setcontent(coefficients.size(), coefficients.constData());
+		QVector<double> Y(X.size());
+		for (auto _ : state){
+			for (int k = 0; k < X.size(); ++k){
+				x.setcontent(1, &X[k]);
+				evaluator->getInternalFunc()(c, x, Y[k], Q_NULLPTR);
+			}
+			Bench::doNotOptimize(Y);
+		}
+		state.setItemsProcessed(state.getIterations() * X.size());
+	}
+}
+
+#define RECORD_LENGTHS {4096}, {8192}, {16384}
+
+static void BM_ReduceChannels(Bench::State& state){
+	auto algorithm = UMF::ReduceChannels::create({{"NumberChannels", numberChannels}});
+	runStage(state, algorithm, stereoRecord(int(state.range(0))));
+}
+BENCHMARK_ARGS(BM_ReduceChannels, RECORD_LENGTHS)
+
+static void BM_Windowing(Bench::State& state){
+	const int recordLength = int(state.range(0));
+	auto algorithm = UMF::Windowing::create({{"Length", recordLength}});
+	runStage(state, algorithm, monoRecord(recordLength));
+}
+BENCHMARK_ARGS(BM_Windowing, RECORD_LENGTHS)
+
+static void BM_ArrayPad(Bench::State& state){
+	auto algorithm = UMF::ArrayPad::create({{"Radius", 8}, {"BorderType", UMF::ArrayPad::constant}});
+	runStage(state, algorithm, monoRecord(int(state.range(0))));
+}
+BENCHMARK_ARGS(BM_ArrayPad, RECORD_LENGTHS)
+
+static void BM_GaussianFilter(Bench::State& state){
+	auto algorithm = UMF::GaussianFilter::create({{"Radius", 8}, {"BorderType", UMF::ArrayPad::constant}});
+	runStage(state, algorithm, monoRecord(int(state.range(0))));
+}
+BENCHMARK_ARGS(BM_GaussianFilter, RECORD_LENGTHS)
+
+/** Filter of a record (first argument) with a range of radii (second argument), across the direct/FFT switch. */
+static void BM_GaussianFilterRadius(Bench::State& state){
+	auto algorithm = UMF::GaussianFilter::create({{"Radius", int(state.range(1))}, {"BorderType", UMF::ArrayPad::reflect}});
+	runStage(state, algorithm, monoRecord(int(state.range(0))));
+}
+BENCHMARK_ARGS(BM_GaussianFilterRadius, {8192, 4}, {8192, 16}, {8192, 32}, {8192, 63}, {8192, 64}, {8192, 128}, {8192, 256})
+
+static void BM_SpectrumMagnitude(Bench::State& state){
+	auto algorithm = UMF::SpectrumMagnitude::create();
+	runStage(state, algorithm, monoRecord(int(state.range(0))));
+}
+BENCHMARK_ARGS(BM_SpectrumMagnitude, RECORD_LENGTHS)
+
+/** Spectra of a number of records (second argument) computed together. */
+static void BM_SpectrumMagnitudeBatch(Bench::State& state){
+	const int recordLength = int(state.range(0));
+	const int numberRecords = int(state.range(1));
+	const auto record = monoRecord(recordLength);
+	QVector<double> records;
+	for (int r = 0; r < numberRecords; ++r) records << record;
+	auto algorithm = UMF::SpectrumMagnitude::create({{"NumberRecords", numberRecords}});
+	runStage(state, algorithm, records);
+}
+BENCHMARK_ARGS(BM_SpectrumMagnitudeBatch, {4096, 16}, {8192, 16}, {16384, 16})
+
+static void BM_SpectrumRemoveBackground(Bench::State& state){
+	auto algorithm = UMF::SpectrumRemoveBackground::create({{"NumberIterations", 6}});
+	runStage(state, algorithm, spectrum(int(state.range(0))));
+}
+BENCHMARK_ARGS(BM_SpectrumRemoveBackground, RECORD_LENGTHS)
+
+#ifdef CAVA_WITH_ROOT
+/** Background estimated by ROOT, the previous implementation; the label reports the difference from the native one. */
+static void BM_SpectrumBackgroundROOT(Bench::State& state){
+	const auto input = spectrum(int(state.range(0)));
+	QVector<double> background(input.size());
+	for (auto _ : state){
+		std::copy(input.begin(), input.end(), background.begin());
+		TSpectrum().Background(background.data(), background.size(), 6, TSpectrum::kBackIncreasingWindow,
+							   TSpectrum::kBackOrder2, false, TSpectrum::kBackSmoothing3, false);
+		Bench::doNotOptimize(background);
+	}
+	state.setItemsProcessed(state.getIterations() * input.size());
+	auto algorithm = UMF::SpectrumRemoveBackground::create({{"NumberIterations", 6}});
+	QVector<double> native(input.size());
+	algorithm->background(input.constData(), input.size(), native.data());
+	double maxError = 0.0;
+	for (int k = 0; k < input.size(); ++k) maxError = std::max(maxError, std::abs(native[k] - background[k]));
+	state.setLabel(QString("max abs. difference %1").arg(maxError));
+}
+BENCHMARK_ARGS(BM_SpectrumBackgroundROOT, RECORD_LENGTHS)
+#endif
+
+/** Histogram of a number of distances, given as argument. */
+static void BM_ComputeHistogram(Bench::State& state){
+	QVector<double> values(int(state.range(0)));
+	std::mt19937 gen(5);
+	std::gamma_distribution<> distance(4.0, 0.15);
+	for (auto& v: values) v = distance(gen);
+	auto histogram = UMF::ComputeHistogram::create({{"BarStep", 0.02}, {"MinimumValue", 0.0}, {"MaximumValue", 2.0}});
+	for (auto _ : state){
+		histogram->setInValues(values);
+		histogram->run();
+		Bench::doNotOptimize(histogram->getOutHistY());
+	}
+	state.setItemsProcessed(state.getIterations() * values.size());
+}
+BENCHMARK_ARGS(BM_ComputeHistogram, {10000}, {1000000})
+
+/** The same distances binned one by one, as they would be produced, without storing them. */
+static void BM_HistogramAccumulator(Bench::State& state){
+	std::mt19937 gen(5);
+	std::gamma_distribution<> distance(4.0, 0.15);
+	UMF::HistogramAccumulator histogram(0.0, 2.0, 0.02);
+	const qint64 count = state.range(0);
+	for (auto _ : state){
+		histogram.clear();
+		for (qint64 k = 0; k < count; ++k) histogram.add(distance(gen));
+		Bench::doNotOptimize(histogram.getBins());
+	}
+	state.setItemsProcessed(state.getIterations() * count);
+}
+BENCHMARK_ARGS(BM_HistogramAccumulator, {10000}, {1000000})
+
+/** Fitting of a histogram with a number of bins given as argument (100 with the default settings). */
+static void BM_FittingGaussExp(Bench::State& state){
+	runFitting<UMF::FittingGaussExp>(state);
+}
+BENCHMARK_ARGS(BM_FittingGaussExp, {50}, {100}, {400})
+
+static void BM_FittingGauss(Bench::State& state){
+	runFitting<UMF::FittingGauss>(state);
+}
+BENCHMARK_ARGS(BM_FittingGauss, {50}, {100}, {400})
+
+/** Evaluation of the fitted curves on a number of points given as argument (as many as plotted, and more). */
+static void BM_EvaluateGaussExp(Bench::State& state){
+	runEvaluation<UMF::EvaluateGaussExp>(state, {1.0, 0.6, 0.15, 0.4});
+}
+BENCHMARK_ARGS(BM_EvaluateGaussExp, {100}, {1000}, {100000})
+
+/** The kernel agrees with ALGLIB within 1e-14 relative, besides the absolute error of alglib::normaldistribution
+ (a few 1e-16), which is relevant in the lower tail only: there the kernel is accurate, see CHECK_NormalCDF.
+ */
+static void CHECK_EvaluateGaussExp(Bench::Check& check){
+	checkEvaluation<UMF::EvaluateGaussExp>(check, 1e-14, [](const QVector<double>& C, double x){
+		return 1e-15 * C[0] * std::exp(- x / C[3]);
+	});
+}
+CHECK(CHECK_EvaluateGaussExp)
+
+static void BM_EvaluateGaussExpAlglib(Bench::State& state){
+	runEvaluationAlglib<UMF::EvaluateGaussExp>(state, {1.0, 0.6, 0.15, 0.4});
+}
+BENCHMARK_ARGS(BM_EvaluateGaussExpAlglib, {100}, {1000}, {100000})
+
+static void BM_EvaluateGauss(Bench::State& state){
+	runEvaluation<UMF::EvaluateGauss>(state, {1.0, 0.6, 0.15});
+}
+BENCHMARK_ARGS(BM_EvaluateGauss, {100}, {1000}, {100000})
+
+/** Both are within 1 ulp of the exponential, but for the subnormal values, which are 0 for the kernel. */
+static void CHECK_EvaluateGauss(Bench::Check& check){
+	checkEvaluation<UMF::EvaluateGauss>(check, 1e-14, [](const QVector<double>& C, double){
+		return C[0] * std::numeric_limits<double>::min();
+	});
+}
+CHECK(CHECK_EvaluateGauss)
+
+/** Normal distribution function against erfc in long double, over the range where it is not subnormal. */
+static void CHECK_NormalCDF(Bench::Check& check){
+	// The reference is only more accurate than the result where long double has extended precision
+	if (std::numeric_limits<long double>::digits < 64) return;
+	const int points = 200000;
+	for (int k = 0; k <= points; ++k){
+		const double z = -37.5 + 45.5 * k / points;
+		const long double reference = 0.5L * std::erfc(- (long double)z / std::sqrt(2.0L));
+		// The bound of UMF::FastMath::normalCDF, plus the rounding of the reference
+		check.expectNear(UMF::FastMath::normalCDF(z), double(reference), 1e-15, 0.0, QString("z %1").arg(z, 0, 'g', 17));
+	}
+}
+CHECK(CHECK_NormalCDF)
+
+static void BM_EvaluateGaussAlglib(Bench::State& state){
+	runEvaluationAlglib<UMF::EvaluateGauss>(state, {1.0, 0.6, 0.15});
+}
+BENCHMARK_ARGS(BM_EvaluateGaussAlglib, {100}, {1000}, {100000})
+
+/** Normalization of a curve over the range of the distances. */
+static void BM_CurveNormalization(Bench::State& state){
+	const QVector<double> coefficients({1.0, 0.6, 0.15, 0.4});
+	auto normalizer = UMF::CurveNormalization::create({{"LeftExtremum", 0.0}, {"RightExtremum", 2.0}});
+	for (auto _ : state){
+		normalizer->setInCoefficients(coefficients);
+		normalizer->run();
+		Bench::doNotOptimize(normalizer->getOutCoefficients());
+	}
+	state.setItemsProcessed(state.getIterations());
+}
+BENCHMARK(BM_CurveNormalization)
+
+/** Integrals of both models against the adaptive quadrature, for every combination of mu, sigma and tau, over the
+ range of the distances, around the mean, on the upper and on the lower tail. The largest tau makes the closed form
+ of the Gauss-exp model lose its digits to cancellation, so that the quadrature is used instead: it must happen.
+ */
+static void CHECK_CurveIntegral(Bench::Check& check){
+	const double nu = 1.3;
+	int fallbacks = 0;
+	for (double mu: {0.3, 0.8, 1.5})
+		for (double sigma: {0.05, 0.2, 0.6})
+			for (double tau: {0.1, 0.4, 2.0, 50.0}){
+				const QVector<double> coefficients({nu, mu, sigma, tau});
+				const double extrema[][2] = {
+					{0.0, 2.0}, {0.5, 1.0}, {mu - 0.5 * sigma, mu + 0.5 * sigma},
+					{mu + 2.0 * sigma, mu + 5.0 * sigma}, {mu - 8.0 * sigma, mu - 4.0 * sigma}
+				};
+				for (const auto& extremum: extrema){
+					// Distances are not negative
+					const double left = std::max(0.0, extremum[0]), right = extremum[1];
+					if (right <= left) continue;
+					if (std::isnan(UMF::EvaluateGaussExp::integral(coefficients.constData(), left, right))) ++fallbacks;
+					for (int model: {UMF::CurveNormalization::gaussExp, UMF::CurveNormalization::gauss}){
+						// The curves are at most nu on the distances, which bounds the absolute error
+						check.expectNear(UMF::CurveNormalization::integral(model, coefficients, left, right),
+										 UMF::CurveNormalization::adaptiveIntegral(model, coefficients, left, right),
+										 1e-10, 1e-14 * nu * (right - left),
+										 QString("model %1, mu %2, sigma %3, tau %4, [%5, %6]").arg(model).arg(mu)
+										 .arg(sigma).arg(tau).arg(left).arg(right));
+					}
+				}
+			}
+	check.expect(fallbacks > 0, "The closed form of the Gauss-exp integral never falls back to the quadrature");
+}
+CHECK(CHECK_CurveIntegral)
+
+/** Integral of the same curve by the adaptive quadrature, the previous implementation. */
+static void BM_CurveIntegralAdaptive(Bench::State& state){
+	const QVector<double> coefficients({1.0, 0.6, 0.15, 0.4});
+	for (auto _ : state)
+		Bench::doNotOptimize(UMF::CurveNormalization::adaptiveIntegral(UMF::CurveNormalization::gaussExp, coefficients, 0.0, 2.0));
+	state.setItemsProcessed(state.getIterations());
+}
+BENCHMARK(BM_CurveIntegralAdaptive)
+
+/** Transform of a record by ALGLIB, the previous implementation of SpectrumMagnitude. */
+static void BM_RealFFTAlglib(Bench::State& state){
+	const auto record = monoRecord(int(state.range(0)));
+	alglib::real_1d_array signal;
+	signal.setcontent(record.size(), record.constData());
+	alglib::complex_1d_array dft;
+	QVector<double> power(record.size()/2+1);
+	for (auto _ : state){
+		alglib::fftr1d(signal, dft);
+		for (int k = 0; k < power.size(); ++k) power[k] = (dft[k].x*dft[k].x + dft[k].y*dft[k].y) / record.size();
+		Bench::doNotOptimize(power);
+	}
+	state.setItemsProcessed(state.getIterations() * record.size());
+}
+BENCHMARK_ARGS(BM_RealFFTAlglib, RECORD_LENGTHS)
+
+/** Transform of a record by the cached plan of UMF::RealFFT; the label reports the difference from ALGLIB. */
+static void BM_RealFFTBuiltin(Bench::State& state){
+	const auto record = monoRecord(int(state.range(0)));
+	const auto plan = UMF::RealFFT::plan(record.size());
+	QVector<double> re(record.size()/2+1), im(record.size()/2+1), power(record.size()/2+1);
+	for (auto _ : state){
+		plan->forward(record.constData(), re.data(), im.data());
+		UMF::RealFFT::power(re.constData(), im.constData(), power.size(), 1.0 / record.size(), power.data());
+		Bench::doNotOptimize(power);
+	}
+	state.setItemsProcessed(state.getIterations() * record.size());
+	// Largest difference of the spectra, relative to their peak
+	alglib::real_1d_array signal;
+	signal.setcontent(record.size(), record.constData());
+	alglib::complex_1d_array dft;
+	alglib::fftr1d(signal, dft);
+	double maxError = 0.0, peak = 0.0;
+	for (int k = 0; k < re.size(); ++k){
+		maxError = std::max(maxError, std::hypot(re[k] - dft[k].x, im[k] - dft[k].y));
+		peak = std::max(peak, std::hypot(dft[k].x, dft[k].y));
+	}
+	state.setLabel(QString("max rel. difference %1").arg(maxError / peak));
+}
+BENCHMARK_ARGS(BM_RealFFTBuiltin, RECORD_LENGTHS)
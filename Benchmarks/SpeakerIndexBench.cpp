@@ -0,0 +1,151 @@
+#include <Benchmark.hpp>
+#include <SyntheticData.hpp>
+#include <AA/PairwiseDistances.hpp>
+#include <AA/SpeakerIndex.hpp>
+#include <QHash>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+	/** Database of synthetic files and unknown files to query it with; short files keep the memory low. */
+	struct SyntheticIndex {
+		QVector<AA::FeaturesSummary> database, queries;
+		AA::PairwiseDistances::Statistics statistics;
+		AA::SpeakerIndex index;
+	};
+
+	const int numberQueries = 100;
+
+	/** Summaries of synthetic files: one in ten has the second feature almost equal to the first one plus a constant,
+	 so that the pooled covariance of two such files is singular and the distance uses the identity instead, and one
+	 in fifty has a single record.
+	 */
+	QVector<AA::FeaturesSummary> checkSummaries(int files, int seed){
+		auto features = Bench::syntheticFeatures(files, 20, seed);
+		std::mt19937 gen(seed);
+		std::normal_distribution<> noise(0.0, 1e-6);
+		QVector<AA::FeaturesSummary> summaries;
+		for(int f = 0; f < files; ++f){
+			auto& F = features[f];
+			if(f % 10 == 1){
+				for(int r = 0; r < F.size()/3; ++r) F[3*r+1] = F[3*r] + 0.5 + noise(gen);
+			}else if(f % 50 == 2){
+				F.resize(3);
+			}
+			summaries << AA::FeaturesSummary::fromFeatures(F);
+		}
+		return summaries;
+	}
+
+	const SyntheticIndex& syntheticIndex(int files){
+		static QHash<int, SyntheticIndex> indexes;
+		if(!indexes.contains(files)){
+			SyntheticIndex data;
+			for(const auto& features: Bench::syntheticFeatures(files + numberQueries, 20))
+				(data.database.size() < files ? data.database : data.queries) << AA::FeaturesSummary::fromFeatures(features);
+			data.statistics.resize(files);
+			for(int k = 0; k < files; ++k) data.statistics.set(k, data.database[k]);
+			data.index = AA::SpeakerIndex(data.database);
+			indexes.insert(files, data);
+		}
+		return indexes[files];
+	}
+}
+
+/** Closest database file of each query by computing every distance, as done before the index. */
+static void BM_NearestLinearScan(Bench::State& state){
+	const auto& data = syntheticIndex(int(state.range(0)));
+	std::vector<double> distances(data.statistics.size());
+	for(auto _ : state){
+		for(const auto& query: data.queries){
+			AA::PairwiseDistances::distances(query, data.statistics, 0, data.statistics.size(), distances.data());
+			Bench::doNotOptimize(std::sqrt(*std::min_element(distances.begin(), distances.end())));
+		}
+	}
+	state.setItemsProcessed(state.getIterations() * numberQueries);
+}
+BENCHMARK_ARGS(BM_NearestLinearScan, {10000}, {100000})
+
+static void BM_SpeakerIndexNearest(Bench::State& state){
+	const auto& data = syntheticIndex(int(state.range(0)));
+	for(auto _ : state){
+		for(const auto& query: data.queries)
+			Bench::doNotOptimize(data.index.nearest(query, int(state.range(1))));
+	}
+	state.setItemsProcessed(state.getIterations() * numberQueries);
+}
+BENCHMARK_ARGS(BM_SpeakerIndexNearest, {10000, 1}, {10000, 10}, {100000, 1}, {100000, 10})
+
+/** Files within the default histogram range, as needed to score an unknown file. */
+static void BM_SpeakerIndexRadius(Bench::State& state){
+	const auto& data = syntheticIndex(int(state.range(0)));
+	QVector<AA::SpeakerIndex::Neighbor> neighbors;
+	qint64 found = 0;
+	for(auto _ : state){
+		for(const auto& query: data.queries){
+			data.index.withinRadius(query, 2.0, neighbors);
+			found += neighbors.size();
+		}
+	}
+	state.setItemsProcessed(state.getIterations() * numberQueries);
+	state.setLabel(QString("%1 files found per query").arg(found / std::max<qint64>(1, state.getIterations() * numberQueries)));
+}
+BENCHMARK_ARGS(BM_SpeakerIndexRadius, {10000}, {100000})
+
+/** Construction of the index, once per loaded database. */
+static void BM_SpeakerIndexBuild(Bench::State& state){
+	const auto& data = syntheticIndex(int(state.range(0)));
+	for(auto _ : state)
+		Bench::doNotOptimize(AA::SpeakerIndex(data.database).size());
+	state.setItemsProcessed(state.getIterations() * state.range(0));
+}
+BENCHMARK_ARGS(BM_SpeakerIndexBuild, {10000}, {100000})
+
+/** Results of the index against the distances from every file, which must be the same. */
+static void CHECK_SpeakerIndex(Bench::Check& check){
+	const auto database = checkSummaries(5000, 3);
+	const auto queries = checkSummaries(200, 4);
+	AA::PairwiseDistances::Statistics statistics;
+	statistics.resize(database.size());
+	for(int k = 0; k < database.size(); ++k) statistics.set(k, database[k]);
+	const AA::SpeakerIndex index(database);
+	std::vector<double> distances(database.size());
+	QVector<AA::SpeakerIndex::Neighbor> neighbors;
+	for(int q = 0; q < queries.size(); ++q){
+		AA::PairwiseDistances::distances(queries[q], statistics, 0, statistics.size(), distances.data());
+		// Files sorted by distance and by index, as returned by the index, which never returns NaN distances
+		std::vector<std::pair<double, int>> sorted;
+		for(int k = 0; k < database.size(); ++k){
+			distances[k] = std::sqrt(distances[k]);
+			if(!std::isnan(distances[k])) sorted.push_back({distances[k], k});
+		}
+		std::sort(sorted.begin(), sorted.end());
+		for(int k: {1, 10}){
+			const auto nearest = index.nearest(queries[q], k);
+			const int expected = std::min<int>(k, sorted.size());
+			if(!check.expect(nearest.size() == expected, QString("query %1: %2 closest files instead of %3").arg(q).arg(nearest.size()).arg(expected)))
+				continue;
+			for(int n = 0; n < expected; ++n)
+				check.expect(nearest[n].Index == sorted[n].second && nearest[n].Distance == sorted[n].first,
+							 QString("query %1: file %2 at %3 is the closest %4 instead of file %5 at %6").arg(q).arg(nearest[n].Index)
+							 .arg(nearest[n].Distance, 0, 'g', 17).arg(n + 1).arg(sorted[n].second).arg(sorted[n].first, 0, 'g', 17));
+		}
+		for(double radius: {0.5, 2.0}){
+			const int farther = index.withinRadius(queries[q], radius, neighbors);
+			std::vector<int> found, expected;
+			for(const auto& neighbor: neighbors) found.push_back(neighbor.Index);
+			std::sort(found.begin(), found.end());
+			int expectedFarther = 0;
+			for(int k = 0; k < database.size(); ++k){
+				if(distances[k] <= radius) expected.push_back(k);
+				else if(distances[k] > radius) ++expectedFarther;
+			}
+			check.expect(found == expected && farther == expectedFarther,
+						 QString("query %1, radius %2: %3 files within and %4 farther instead of %5 and %6").arg(q).arg(radius)
+						 .arg(found.size()).arg(farther).arg(expected.size()).arg(expectedFarther));
+		}
+	}
+}
+CHECK(CHECK_SpeakerIndex)
@@ -0,0 +1,77 @@
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <SyntheticData.hpp>
+
+QVector<qint16> Bench::syntheticSignal(qint64 frames, int sampleRate, int channels, int seed){
+	QVector<qint16> samples(frames * channels);
+	std::mt19937 gen(seed);
+	std::normal_distribution<> noise(0.0, 0.05);
+	std::uniform_real_distribution<> pitch(100.0, 250.0);
+	const double f0 = pitch(gen);
+	double phase = 0.0;
+	for(qint64 n = 0; n < frames; ++n){
+		// Slow pitch modulation, as in natural speech
+		double t = double(n) / sampleRate;
+		phase += 2 * M_PI * f0 * (1.0 + 0.05 * sin(2 * M_PI * 3.0 * t)) / sampleRate;
+		double value = 0.4 * sin(phase) + 0.2 * sin(3 * phase) + 0.1 * sin(6 * phase);
+		for(int c = 0; c < channels; ++c)
+			samples[n*channels+c] = qint16(std::clamp(value + noise(gen), -1.0, 1.0) * 0x7FFF);
+	}
+	return samples;
+}
+
+QString Bench::writeSyntheticWav(const QString& fileName, double seconds, int sampleRate, int channels, int seed){
+	QFile file(fileName);
+	if(!file.open(QFile::WriteOnly)) return QString();
+	const auto samples = syntheticSignal(qint64(seconds * sampleRate), sampleRate, channels, seed);
+	const quint32 dataSize = samples.size() * 2;
+	QDataStream stream(&file);
+	stream.setByteOrder(QDataStream::LittleEndian);
+	stream.writeRawData("RIFF", 4);
+	stream << quint32(36 + dataSize);
+	stream.writeRawData("WAVE", 4);
+	stream.writeRawData("fmt ", 4);
+	stream << quint32(16) << quint16(1) << quint16(channels) << quint32(sampleRate)
+	<< quint32(sampleRate * channels * 2) << quint16(channels * 2) << quint16(16);
+	stream.writeRawData("data", 4);
+	stream << dataSize;
+	for(const auto& sample: samples) stream << sample;
+	return fileName;
+}
+
+QStringList Bench::syntheticWavFiles(int count, double seconds, int sampleRate, int channels){
+	static QTemporaryDir dir;
+	static QHash<QString, QStringList> sets;
+	const QString key = QString("%1-%2-%3-%4").arg(count).arg(seconds).arg(sampleRate).arg(channels);
+	if(!sets.contains(key)){
+		QStringList files;
+		for(int k = 0; k < count; ++k)
+			files << writeSyntheticWav(QDir(dir.path()).filePath(key+"-"+QString::number(k)+".wav"), seconds, sampleRate, channels, k);
+		sets.insert(key, files);
+	}
+	return sets.value(key);
+}
+
+QList<QVector<double>> Bench::syntheticFeatures(int files, int recordsPerFile, int seed){
+	QList<QVector<double>> features;
+	std::mt19937 gen(seed);
+	std::uniform_real_distribution<> center(1.0, 3.0), weight(0.0, 1.0);
+	std::normal_distribution<> noise(0.0, 0.3);
+	for(int f = 0; f < files; ++f){
+		QVector<double> F(3 * recordsPerFile);
+		const double cx = center(gen), cy = center(gen);
+		for(int r = 0; r < recordsPerFile; ++r){
+			F[3*r] = cx + noise(gen);
+			F[3*r+1] = cy + noise(gen);
+			F[3*r+2] = weight(gen);
+		}
+		features << F;
+	}
+	return features;
+}
@@ -0,0 +1,31 @@
+#ifndef SyntheticData_hpp
+#define SyntheticData_hpp
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace Bench {
+	/** Interleaved 16 bit voice-like signal: a few harmonics of a varying pitch plus noise.
+	 @param[in] seed Seed of the noise and of the pitch, so that different files differ.
+	 */
+	QVector<qint16> syntheticSignal(qint64 frames, int sampleRate, int channels, int seed = 0);
+
+	/** Write a 16 bit PCM WAV file with a synthetic signal.
+	 @return The file path, or an empty string on error.
+	 */
+	QString writeSyntheticWav(const QString& fileName, double seconds, int sampleRate = 44100, int channels = 2, int seed = 0);
+
+	/** Create (once) and return a set of synthetic WAV files in a temporary directory.
+	 Files are shared among the benchmarks asking for the same count and duration.
+	 */
+	QStringList syntheticWavFiles(int count, double seconds, int sampleRate = 44100, int channels = 2);
+
+	/** Features of synthetic files, as given by AA::FeaturesExtractor: the first two features of each
+	 file are scattered around a random center, the third one is a random weight.
+	 */
+	QList<QVector<double>> syntheticFeatures(int files, int recordsPerFile = 200, int seed = 7);
+}
+
+#endif /* SyntheticData_hpp */
@@ -0,0 +1,102 @@
+#include <Benchmark.hpp>
+#include <SyntheticData.hpp>
+#include <AA/WavReader.hpp>
+#include <UMF/ParallelFor.hpp>
+#include <QFileInfo>
+#include <QThread>
+#include <atomic>
+
+namespace {
+	const int numberFiles = 32;
+	const double fileSeconds = 2.0;
+	const int bufferSamples = 16384;
+
+	/** Open and decode a fixed set of files on a given number of threads.
+	 With the previous reader every open went through a process-wide mutex, so the
+	 throughput could not grow with the threads; it is expected to scale now.
+	 */
+	void openDecode(Bench::State& state, int threads){
+		const auto files = Bench::syntheticWavFiles(numberFiles, fileSeconds);
+		qint64 bytes = 0;
+		for(const auto& file: files) bytes += QFileInfo(file).size();
+		std::atomic<qint64> samples(0);
+		for(auto _ : state){
+			UMF::parallelFor(0, files.size(), 1, threads, [&](int begin, int end, int){
+				AA::WavReader reader;
+				QVector<qint16> buffer(bufferSamples);
+				for(int k = begin; k < end; ++k){
+					if(!reader.open(files[k])) continue;
+					qint64 read;
+					while((read = reader.read(buffer.data(), bufferSamples)) > 0) samples += read;
+				}
+			});
+		}
+		Bench::doNotOptimize(samples);
+		state.setItemsProcessed(state.getIterations() * files.size());
+		state.setBytesProcessed(state.getIterations() * bytes);
+		state.setLabel(QString("%1 files").arg(files.size()));
+	}
+
+	/** Register one benchmark per number of threads, doubling up to the available cores. */
+	int registerOpenDecode(){
+		const int maxThreads = std::max(1, QThread::idealThreadCount());
+		for(int threads = 1;; threads = std::min(2 * threads, maxThreads)){
+			Bench::registerBenchmark(QString("BM_WavOpenDecode/threads:%1").arg(threads),
+									 [threads](Bench::State& state){openDecode(state, threads);});
+			if(threads == maxThreads) break;
+		}
+		return 0;
+	}
+}
+
+static int BM_WavOpenDecode_registration = registerOpenDecode();
+
+namespace {
+	const int recordSamples = 8192 * 2;
+
+	/** Sum of a record, so that every sample is actually touched. */
+	qint64 touch(const qint16* samples){
+		qint64 sum = 0;
+		for(int k = 0; k < recordSamples; ++k) sum += samples[k];
+		return sum;
+	}
+}
+
+/** Records copied out of the file one by one. */
+static void BM_WavRecordsRead(Bench::State& state){
+	const auto file = Bench::syntheticWavFiles(1, 60.0).first();
+	AA::WavReader reader;
+	reader.open(file);
+	QVector<qint16> buffer(recordSamples);
+	const qint64 records = reader.getSampleCount() / recordSamples;
+	qint64 sum = 0;
+	for(auto _ : state){
+		reader.seek(0);
+		for(qint64 r = 0; r < records; ++r){
+			reader.read(buffer.data(), recordSamples);
+			sum += touch(buffer.constData());
+		}
+	}
+	Bench::doNotOptimize(sum);
+	state.setItemsProcessed(state.getIterations() * records);
+	state.setBytesProcessed(state.getIterations() * records * recordSamples * 2);
+}
+BENCHMARK(BM_WavRecordsRead)
+
+/** Records accessed in place through the mapping. */
+static void BM_WavRecordsView(Bench::State& state){
+	const auto file = Bench::syntheticWavFiles(1, 60.0).first();
+	AA::WavReader reader;
+	reader.open(file);
+	const qint64 records = reader.getSampleCount() / recordSamples;
+	qint64 sum = 0;
+	for(auto _ : state){
+		for(qint64 r = 0; r < records; ++r)
+			sum += touch(reader.view(r * recordSamples, recordSamples));
+	}
+	Bench::doNotOptimize(sum);
+	state.setItemsProcessed(state.getIterations() * records);
+	state.setBytesProcessed(state.getIterations() * records * recordSamples * 2);
+	state.setLabel(reader.isMapped() ? "mapped" : "not mapped");
+}
+BENCHMARK(BM_WavRecordsView)
@@ -0,0 +1,126 @@
+#ifndef DatabaseFile_hpp
+#define DatabaseFile_hpp
+
+#include <QFile>
+#include <QString>
+#include <QVariantMap>
+#include <QVector>
+#include <AA/FeaturesSummary.hpp>
+
+namespace AA {
+	class DatabaseFile;
+}
+
+/** Binary database of fitted curves and of the features of the enrolled files.
+ The file starts with a versioned header, followed by sections aligned to 64 bytes:
+ - the features of every file, in a single contiguous array of doubles (three per record, as
+   given by AA::FeaturesExtractor), with an index of N+1 offsets delimiting the block of each file;
+ - the summaries of the files, one array per statistic (the layout of AA::PairwiseDistances::Statistics);
+ - the group (speaker) and the name of every file;
+ - the curves, with their model, range, coefficients and the range of files they were fitted on;
+ - the histograms the curves were fitted to, so that files can be added without computing the distances of the others again;
+ - the parameters used to create the database (e.g. the settings of the extraction), serialized by QDataStream.
+ Values are stored in the byte order of the machine which wrote the file, which is checked when opening it.
+ Opening maps the file and only validates the header, so that it takes constant time whatever the
+ size of the database; the features are then read in place, through pointers into the mapping, and
+ are never copied. Files of version 1, which have no histograms, are still read; other versions are rejected.
+ */
+class AA::DatabaseFile {
+
+public:
+	/** Curve fitted to the distribution of the distances of a range of files. */
+	struct Curve {
+		QString Name;
+		/** Model of the curve, as in UMF::CurveNormalization::model. */
+		int Model = 0;
+		/** Color of the curve, as a QRgb value. */
+		quint32 Color = 0;
+		/** Range of the fitted histogram. */
+		double Minimum = 0.0;
+		double Maximum = 1.0;
+		QVector<double> Coefficients;
+		/** Files the distances were computed on, [FirstFile, FirstFile+NumberFiles). */
+		int FirstFile = 0;
+		int NumberFiles = 0;
+		/** Histogram of the distances, with the bins of AA::PairwiseDistances over [HistogramMinimum, HistogramMaximum]:
+		 the number of distances in every bin, empty if not stored.
+		 */
+		double HistogramMinimum = 0.0;
+		double HistogramMaximum = 0.0;
+		double BarStep = 0.0;
+		QVector<double> Counts;
+	};
+
+	/** A file to be stored; the features are referred to, not owned. */
+	struct File {
+		/** Features, three values per record. */
+		const double* Features = Q_NULLPTR;
+		qint64 Size = 0;
+		FeaturesSummary Summary;
+		int Group = 0;
+		QString Name;
+	};
+
+	/** Everything stored in a database. */
+	struct Contents {
+		QVector<Curve> Curves;
+		QVector<File> Files;
+		QVariantMap Parameters;
+	};
+
+	DatabaseFile() = default;
+	DatabaseFile(const DatabaseFile&) = delete;
+	DatabaseFile& operator=(const DatabaseFile&) = delete;
+
+	/** Write a database; the file is replaced atomically.
+	 @param[out] error Description of the error, if any.
+	 @return false if the file cannot be written.
+	 */
+	static bool save(const QString& fileName, const Contents& contents, QString* error = Q_NULLPTR);
+
+	/** Map a database and check its header.
+	 @return false if the file cannot be mapped or is not a database of this version; the reason is given by getError.
+	 */
+	bool open(const QString& fileName);
+
+	/** Description of the last error. */
+	QString getError() const {return error;};
+
+	/** Whether the file has the signature of a database, whatever its version. */
+	static bool isDatabaseFile(const QString& fileName);
+
+	int getNumberFiles() const;
+	int getNumberCurves() const;
+
+	Curve getCurve(int c) const;
+
+	/** Features of a file, in place.
+	 @param[out] size Number of values, three per record.
+	 @return Pointer into the mapping, valid while the database is open, or Q_NULLPTR if the index is corrupted.
+	 */
+	const double* getFeatures(int k, qint64& size) const;
+
+	FeaturesSummary getSummary(int k) const;
+	int getGroup(int k) const;
+	QString getName(int k) const;
+
+	/** Parameters stored with the database; they are deserialized at every call. */
+	QVariantMap getParameters() const;
+
+	/** Every file, with the features referring to the mapping, e.g. to store them in another database. */
+	File getFile(int k) const;
+
+private:
+	QFile file;
+	QString error;
+	const uchar* mapped = Q_NULLPTR;
+
+	bool fail(const QString& description);
+
+	/** Pointer to the given byte of the mapping. */
+	template <typename T> const T* at(quint64 offset) const {return reinterpret_cast<const T*>(mapped + offset);};
+
+	QString string(quint64 offset, quint64 size) const;
+};
+
+#endif /* DatabaseFile_hpp */
@@ -0,0 +1,57 @@
+#ifndef FeaturesCache_hpp
+#define FeaturesCache_hpp
+
+#include <QByteArray>
+#include <QDir>
+#include <QString>
+#include <QVector>
+#include <AA/FeaturesSummary.hpp>
+
+namespace AA {
+	class FeaturesCache;
+}
+
+/** Persistent on-disk cache of the features extracted from audio files.
+ Each entry is identified by the audio file (its canonical path, size and last
+ modification time) and by a description of the extraction parameters, so that
+ it is automatically invalidated when either the audio or the parameters change.
+ Entries are written atomically, hence several threads and processes can share
+ the same cache folder.
+ */
+class AA::FeaturesCache {
+
+public:
+	/** Outputs of AA::FeaturesExtractor stored for a file. */
+	struct Entry {
+		QVector<double> Features;
+		FeaturesSummary Summary;
+		double SampleRate = 0.0;
+		int TotalRecords = 0;
+		int RecordLength = 0;
+	};
+
+	/** Create a cache in the given folder, which is created if missing. */
+	explicit FeaturesCache(const QString& folder);
+
+	/** Default cache folder, in the cache location of the application. */
+	static QString defaultFolder();
+
+	/** Look for the features of a file.
+	 @param[in] parameters Serialized extraction parameters.
+	 @return false if the entry is missing or unreadable.
+	 */
+	bool load(const QString& file, const QByteArray& parameters, Entry& entry) const;
+
+	/** Store the features of a file.
+	 @return false if the entry cannot be written.
+	 */
+	bool store(const QString& file, const QByteArray& parameters, const Entry& entry) const;
+
+private:
+	QDir folder;
+
+	/** Path of the entry of a file, or an empty string if the file does not exist. */
+	QString entryPath(const QString& file, const QByteArray& parameters) const;
+};
+
+#endif /* FeaturesCache_hpp */
@@ -3,7 +3,9 @@
 
 #include <QVariantList>
 #include <QAlgorithm.hpp>
-#include <armadillo>
+#include <AA/FeaturesSummary.hpp>
+#include <AA/SymmetricMatrix2.hpp>
+#include <stdexcept>
 
 namespace AA {
 	class FeaturesDistance;
@@ -19,14 +21,23 @@ class AA::FeaturesDistance : public QAlgorithm {
 	QA_CTOR_INHERIT
 	QA_IMPL_CREATE(FeaturesDistance)
 	
-private:
-	arma::mat weightMean(const arma::mat& X,
-						 const arma::mat& W);
-	arma::mat weightCov(const arma::mat& X,
-						const arma::vec& W);
-	
 public:
 	void run();
+	
+	/** Compute the distance between two features arrays.
+	 This is the computation performed by run, made available to callers
+	 that do not need an algorithm instance (e.g. batch tools).
+	 @throw std::runtime_error if the inputs have inconsistent dimensions.
+	 */
+	static double compute(const QVector<double>& Features1,
+						  const QVector<double>& Features2);
+	
+	/** Compute the distance between two files from their summaries, in constant time.
+	 The result is the one of the features arrays the summaries come from. The 2x2 matrix
+	 algebra is carried out in closed form, see AA::SymmetricMatrix2.
+	 */
+	static double compute(const FeaturesSummary& Summary1,
+						  const FeaturesSummary& Summary2);
 };
 
 #endif /* FeaturesDistance_hpp */
@@ -1,18 +1,17 @@
 #ifndef FeaturesExtractor_hpp
 #define FeaturesExtractor_hpp
 
+#include <QDataStream>
 #include <QScopedPointer>
+#include <QMutex>
+#include <memory>
 #include <QAlgorithm.hpp>
 #include <UMF/SignalProcessing.hpp>
-#include <SFML/Audio/InputSoundFile.hpp>
-#include <SFML/System/Mutex.hpp>
-#include <SFML/System/Lock.hpp>
-#include <TMath.h>
-#include <ROOT/TSeq.hxx>
-#include <TSpectrum.h>
-#include <TVector.h>
-#include <TH1D.h>
-#include <TF1.h>
+#include <AA/FeaturesCache.hpp>
+#include <AA/FeaturesSummary.hpp>
+#include <AA/RecordPipeline.hpp>
+#include <AA/WavReader.hpp>
+#include <UMF/ParallelFor.hpp>
 #include <alglib/fasttransforms.h>
 
 namespace AA {
@@ -34,13 +33,30 @@ class AA::FeaturesExtractor : public QAlgorithm {
 	QA_OUTPUT(int, TotalRecords)
 	/** Record length in samples */
 	QA_OUTPUT(int, RecordLength)
+	/** Samples between the beginnings of consecutive records. */
+	QA_OUTPUT(int, RecordHop)
 	/** The features computed during the process. */
 	QA_OUTPUT(QVector<double>, Features)
+	/** Summary of the features, to compute distances without going through them again. */
+	QA_OUTPUT(AA::FeaturesSummary, Summary)
 	
 	/** Directory pointing to the file to be read. */
 	QA_PARAMETER(QString, File, QString())
 	/** Record index to be evaluated. */
 	QA_PARAMETER(int, SelectRecord, -1)
+	/** Number of threads processing the records of the file.
+	 The file is split in ranges of records that are extracted in parallel, each thread
+	 reading the file on its own; useful for long files. Values lower than 1 select the number
+	 of available cores. The evaluation of a single record is always serial.
+	 */
+	QA_PARAMETER(int, NumberThreads, 1)
+	/** Folder of the persistent features cache; an empty string disables the cache.
+	 Features already extracted from the same file with the same parameters are loaded
+	 from the cache instead of being computed again. The inspection of a single record
+	 never uses the cache.
+	 @sa AA::FeaturesCache
+	 */
+	QA_PARAMETER(QString, CacheFolder, QString())
 	/** Minimum frequency allowed */
 	QA_PARAMETER(double, MinimumFrequency, 200.0)
 	/** Maximum frequency allowed */
@@ -52,6 +68,13 @@ class AA::FeaturesExtractor : public QAlgorithm {
 	 in <a href="http://www.jot.fm/issues/issue_2009_11/column2/">Douglas A. Lyon: “The Discrete Fourier Transform, Part 4: Spectral Leakage”</a>.
 	 */
 	QA_PARAMETER(double, MaximumSpectrumLeakage, 10.0)
+	/** Samples between the beginnings of consecutive records.
+	 Values lower than the record length make the records overlap (e.g. half the record length
+	 for a 50% overlap, a quarter for 75%), giving denser features without shortening the records;
+	 the file is still read once, and each sample is converted and reduced once. Values out of
+	 (0, RecordLength) select contiguous records. Overlapping records require interleaved channels (or a single channel).
+	 */
+	QA_PARAMETER(int, HopLength, 0)
 	/** Operation performed to reduce channles.
 	 @sa UMF::ReduceChannels, UMF::ReduceChannels::operation
 	 */
@@ -79,11 +102,11 @@ class AA::FeaturesExtractor : public QAlgorithm {
 	/** Direction used for background suppression.
 	 @sa UMF::SpectrumRemoveBackground
 	 */
-	QA_PARAMETER(int, BackDirection, TSpectrum::kBackIncreasingWindow)
+	QA_PARAMETER(int, BackDirection, UMF::SpectrumRemoveBackground::kBackIncreasingWindow)
 	/** Filter order used for background suppression.
 	 @sa UMF::SpectrumRemoveBackground
 	 */
-	QA_PARAMETER(int, BackFilterOrder, TSpectrum::kBackOrder2)
+	QA_PARAMETER(int, BackFilterOrder, UMF::SpectrumRemoveBackground::kBackOrder2)
 	/** Whether applying a smoothing in background suppression.
 	 @sa UMF::SpectrumRemoveBackground
 	 */
@@ -91,7 +114,7 @@ class AA::FeaturesExtractor : public QAlgorithm {
 	/** Smoothing window size used for background suppression.
 	 @sa UMF::SpectrumRemoveBackground
 	 */
-	QA_PARAMETER(int, BackSmoothWindow, TSpectrum::kBackSmoothing3)
+	QA_PARAMETER(int, BackSmoothWindow, UMF::SpectrumRemoveBackground::kBackSmoothing3)
 	/** Whether computing Compton edges in background suppression.
 	 @sa UMF::SpectrumRemoveBackground
 	 */
@@ -103,13 +126,31 @@ class AA::FeaturesExtractor : public QAlgorithm {
 public:
 	void run();
 	
+	/** Collect the parameters of the processing chain for a signal with the given sample rate and number of channels.
+	 The record length and the hop length are derived from MaximumSpectrumLeakage and HopLength
+	 as run does, so that other sources of samples (e.g. AA::StreamingExtractor) give the same features.
+	 */
+	RecordPipeline::Parameters getPipelineParameters(double sampleRate, int numberChannels);
+	
 Q_SIGNALS:
 	Q_SIGNAL void timeSeries(QVector<double>);
 	Q_SIGNAL void frequencySeries(QVector<double>);
 	Q_SIGNAL void pointSeries(QVector<int>);
 	
 private:
-	static sf::Mutex mutex;
+	/** Serialize the parameters affecting the features, used to identify the cache entries. */
+	QByteArray getCacheParameters();
+	
+	/** Extract the features of the given number of records on a pool of threads.
+	 The features of the records are stored in order, as the serial extraction does.
+	 @return false if an error occurred (the algorithm is aborted).
+	 */
+	bool extractParallel(const RecordPipeline::Parameters& parameters, int numRecords, QVector<double>& features);
+	
+	/** Extract the features of the given number of overlapping records, pushing the hops in order.
+	 @return false if an error occurred (the algorithm is aborted).
+	 */
+	bool extractHops(WavReader& file, const RecordPipeline::Parameters& parameters, int numRecords, QVector<double>& features);
 };
 
 #endif /* FeaturesExtractor_hpp */
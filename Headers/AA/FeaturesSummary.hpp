@@ -0,0 +1,40 @@
+#ifndef FeaturesSummary_hpp
+#define FeaturesSummary_hpp
+
+#include <QDataStream>
+#include <QMetaType>
+#include <QVector>
+#include <cmath>
+#include <limits>
+
+namespace AA {
+	struct FeaturesSummary;
+}
+
+/** Sufficient statistics of the features of a file.
+ The distance between two files computed by AA::FeaturesDistance only depends on the
+ number of records and on the weighted mean and covariance of the first two features of
+ each file, weighted by the third one. Computing them once, when the extraction finishes,
+ reduces every distance to a constant time operation.
+ */
+struct AA::FeaturesSummary {
+	/** Number of records. */
+	int Count = 0;
+	/** Weighted mean. */
+	double MeanX = std::numeric_limits<double>::quiet_NaN();
+	double MeanY = std::numeric_limits<double>::quiet_NaN();
+	/** Weighted covariance; the identity when there is a single record. */
+	double CovXX = 1.0;
+	double CovXY = 0.0;
+	double CovYY = 1.0;
+	
+	/** Compute the summary of an array of features, as given by AA::FeaturesExtractor. */
+	static FeaturesSummary fromFeatures(const QVector<double>& features);
+};
+
+Q_DECLARE_METATYPE(AA::FeaturesSummary)
+
+QDataStream& operator<<(QDataStream& stream, const AA::FeaturesSummary& summary);
+QDataStream& operator>>(QDataStream& stream, AA::FeaturesSummary& summary);
+
+#endif /* FeaturesSummary_hpp */
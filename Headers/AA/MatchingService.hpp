@@ -0,0 +1,80 @@
+#ifndef MatchingService_hpp
+#define MatchingService_hpp
+
+#include <QVector>
+#include <limits>
+#include <AA/FeaturesSummary.hpp>
+#include <AA/SpeakerIndex.hpp>
+
+namespace AA {
+	class MatchingService;
+}
+
+/** Score unknown files, one by one, against a database loaded once.
+ Every unknown file is tested as AA::ComputeProbability tests a folder: the distances from the
+ database files are binned in a histogram, and the score is the average of the intra-speaker and
+ extra-speaker curves integrated up to its centroid. The database files are indexed by AA::SpeakerIndex
+ and the curves are normalized in the constructor, so that a score only costs the distances of the files
+ which can fall in the histogram range and two closed-form integrals, and the unknown files are scored in parallel.
+ The methods are const, so that they can also be called from any number of threads, e.g. by the
+ consumers of a queue of files.
+ */
+class AA::MatchingService {
+
+public:
+	/** Parameters of the histogram and of the test.
+	 Their meaning is the same as the homonymous ones of AA::PairwiseDistances and AA::ComputeProbability.
+	 */
+	struct Parameters {
+		double MinimumValue = 0.0;
+		double MaximumValue = 2.0;
+		double BarStep = 0.02;
+		double LeftExtremum = 0.0;
+		double RightExtremum = 2.0;
+		/** Number of threads; values lower than 1 select the number of available cores. */
+		int NumberThreads = 0;
+	};
+
+	/** Result of the test of an unknown file. */
+	struct Match {
+		/** Probability that the unknown voice belongs to the database speaker, or -1 if inconclusive
+		 (no distance in the histogram range).
+		 */
+		double Score = -1.0;
+		/** Centroid of the histogram of the distances. */
+		double Centroid = std::numeric_limits<double>::quiet_NaN();
+		/** Index of the closest database file, and its distance. */
+		int Closest = -1;
+		double ClosestDistance = std::numeric_limits<double>::infinity();
+	};
+
+	/** @param[in] database Summaries of the database files.
+	 @param[in] intraCoefficients Coefficients of the Gauss-exp curve fitted to the intra-speaker distances.
+	 @param[in] extraCoefficients Coefficients of the Gauss-exp curve fitted to the extra-speaker distances.
+	 */
+	MatchingService(const QVector<FeaturesSummary>& database,
+					const QVector<double>& intraCoefficients,
+					const QVector<double>& extraCoefficients,
+					const Parameters& parameters);
+
+	/** Test an unknown file. */
+	Match match(const FeaturesSummary& unknown) const;
+
+	/** Test every unknown file on its own, in parallel. */
+	QVector<Match> match(const QVector<FeaturesSummary>& unknowns) const;
+
+	int getDatabaseSize() const {return index.size();};
+
+private:
+	Parameters parameters;
+	/** Index of the database files. */
+	SpeakerIndex index;
+	/** Curves normalized over [LeftExtremum, RightExtremum]. */
+	QVector<double> intra, extra;
+
+	/** Buffers of a thread. */
+	struct Workspace;
+	Match match(const FeaturesSummary& unknown, Workspace& workspace) const;
+};
+
+#endif /* MatchingService_hpp */
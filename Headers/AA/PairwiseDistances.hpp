@@ -0,0 +1,101 @@
+#ifndef PairwiseDistances_hpp
+#define PairwiseDistances_hpp
+
+#include <QVector>
+#include <QList>
+#include <QThread>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <vector>
+#include <QAlgorithm.hpp>
+#include <AA/FeaturesSummary.hpp>
+#include <AA/SymmetricMatrix2.hpp>
+#include <UMF/ConcurrentHistogram.hpp>
+#include <UMF/ParallelFor.hpp>
+
+namespace AA {
+	class PairwiseDistances;
+}
+
+/** Histogram of the distances between every pair of a set of files.
+ The distance is the one computed by AA::FeaturesDistance. Instead of creating an
+ algorithm for each pair, the summaries of the files are given as input, then the pairs are processed in cache-sized tiles on a pool of threads: every
+ file of a row block is compared with a contiguous block of files whose statistics
+ are stored in structure-of-arrays layout, so that the inner loop is vectorized.
+ The distances are counted straight into the per-thread shards of a UMF::ConcurrentHistogram,
+ merged at the end, so that they are never stored and the threads never contend for the bins. The bins have width BarStep and start at
+ MinimumValue, the last one contains MaximumValue; distances out of this range are discarded.
+ Files are enrolled incrementally by giving the counts of the histogram of the files already enrolled: only the
+ pairs with at least one new file are compared, and their distances are added to those counts, so that the cost
+ grows with the number of new files rather than with the square of the size of the database.
+ */
+class AA::PairwiseDistances : public QAlgorithm {
+	
+	Q_OBJECT
+	
+public:
+	enum pairs {
+		intra,	// pairs of files in the same group
+		extra,	// pairs of files in different groups
+		all		// every pair of files
+	};
+	Q_ENUM(pairs)
+	
+	/** Summary of every file, as computed by AA::FeaturesExtractor. */
+	QA_INPUT(QVector<AA::FeaturesSummary>, Summaries)
+	/** Group (e.g. the speaker) of every file, in the same order as Summaries. */
+	QA_INPUT(QVector<int>, Groups)
+	/** Count of every bin of the histogram of the first NumberEnrolled files, as given by Counts; empty if none. */
+	QA_INPUT(QVector<double>, EnrolledCounts)
+	/** Bin centers. */
+	QA_OUTPUT(QVector<double>, HistX)
+	/** Number of distances in each bin. */
+	QA_OUTPUT(QVector<double>, HistY)
+	/** Number of distances computed, including the ones out of the histogram range. */
+	QA_OUTPUT(qint64, NumberDistances)
+	/** Number of distances in every bin, empty ones included, with the enrolled counts; they are the
+	 EnrolledCounts of the following enrollment.
+	 */
+	QA_OUTPUT(QVector<double>, Counts)
+	/** Which pairs of files are compared.
+	 @sa pairs
+	 */
+	QA_PARAMETER(int, Pairs, intra)
+	QA_PARAMETER(double, BarStep, 0.02)
+	QA_PARAMETER(double, MinimumValue, 0.0)
+	QA_PARAMETER(double, MaximumValue, 2.0)
+	QA_PARAMETER(bool, SuppressZeroCount, true)
+	/** Number of threads; values lower than 1 select the number of available cores. */
+	QA_PARAMETER(int, NumberThreads, 0)
+	/** Number of files already enrolled, the first ones of Summaries: the pairs of two of them are not compared again. */
+	QA_PARAMETER(int, NumberEnrolled, 0)
+	
+	QA_CTOR_INHERIT
+	QA_IMPL_CREATE(PairwiseDistances)
+	
+public:
+	void run();
+	
+	/** Weighted statistics of a set of files, one array per element, so that the distances from
+	 a file to a contiguous block of them are computed in a vectorized loop.
+	 */
+	struct Statistics {
+		QVector<double> count, meanX, meanY, covXX, covXY, covYY;
+		void resize(int size);
+		void set(int k, const AA::FeaturesSummary& summary);
+		AA::FeaturesSummary get(int k) const;
+		int size() const {return count.size();};
+	};
+	
+	/** Compute the squared distances between the file with the given summary and files [begin, end) of S.
+	 The square root is left to the caller, as it would prevent the vectorization of the loop.
+	 */
+	static void distances(const AA::FeaturesSummary& summary, const Statistics& S, int begin, int end, double* out);
+	
+Q_SIGNALS:
+	Q_SIGNAL void histogramReady(QVector<double> Bin, QVector<double> Count);
+};
+
+#endif /* PairwiseDistances_hpp */
@@ -0,0 +1,130 @@
+#ifndef RecordPipeline_hpp
+#define RecordPipeline_hpp
+
+#include <QVector>
+#include <QSharedPointer>
+#include <UMF/SignalProcessing.hpp>
+
+namespace AA {
+	class RecordPipeline;
+}
+
+/** Fused per-record processing chain of AA::FeaturesExtractor.
+ The chain converts a record of 16 bit samples, reduces its channels, applies
+ the window, the Gaussian filter, computes the spectrum, removes its background
+ and finally computes the features. Every stage and every intermediate buffer is
+ created once in the constructor, so that processing records of the same file
+ keeps reusing the same memory. The results are the same as the ones obtained
+ chaining the corresponding UMF algorithms.
+ Overlapping records are processed incrementally: the reduced samples of the current
+ record are kept in a ring buffer, so that every sample is converted and reduced once,
+ when the hop bringing it into a record is pushed.
+ */
+class AA::RecordPipeline {
+
+public:
+	/** Parameters of the chain.
+	 Their meaning is the same as the homonymous AA::FeaturesExtractor ones.
+	 */
+	struct Parameters {
+		double SampleRate = 0.0;
+		int RecordLength = 0;
+		/** Samples between the beginnings of consecutive records; values not in (0, RecordLength) select contiguous records. */
+		int HopLength = 0;
+		int NumberChannels = 1;
+		double MinimumFrequency = 200.0;
+		double MaximumFrequency = 4000.0;
+		int ChannelsOperation = UMF::ReduceChannels::average;
+		int ChannelsArrangement = UMF::ReduceChannels::interleaved;
+		int WindowingFunction = UMF::Windowing::hann;
+		int ExtrapolationMethod = UMF::ArrayPad::constant;
+		int GaussianFilterWidth = 5;
+		int BackIterations = 6;
+		int BackDirection = UMF::SpectrumRemoveBackground::kBackIncreasingWindow;
+		int BackFilterOrder = UMF::SpectrumRemoveBackground::kBackOrder2;
+		bool BackSmoothing = false;
+		int BackSmoothWindow = UMF::SpectrumRemoveBackground::kBackSmoothing3;
+		bool BackCompton = false;
+	};
+
+	explicit RecordPipeline(const Parameters& parameters);
+
+	/** Process a record.
+	 @param[in] samples Record of RecordLength*NumberChannels samples; it can point straight into a mapped file.
+	 @param[out] features Array of three elements receiving V1, V2 and the spectral concentration.
+	 @return An error description, or Q_NULLPTR on success.
+	 */
+	const char* process(const qint16* samples, double* features);
+
+	/** Process consecutive records, computing their spectra together.
+	 The features are the same as the ones given by process, record by record, while
+	 the spectra of the records are computed by UMF::SpectrumMagnitude::applyBatch.
+	 The intermediate series are not kept.
+	 @param[in] samples count records of RecordLength*NumberChannels samples, laid out contiguously.
+	 @param[out] features Array of 3*count elements.
+	 @return An error description, or Q_NULLPTR on success.
+	 */
+	const char* processBatch(const qint16* samples, int count, double* features);
+
+	/** Start a sequence of overlapping records.
+	 The ring buffer is filled with the samples that the first record shares with the
+	 previous (missing) one, so that processHops can then complete one record per hop.
+	 @param[in] samples (RecordLength-HopLength)*NumberChannels interleaved samples.
+	 */
+	void startHops(const qint16* samples);
+
+	/** Process overlapping records, each one shifted by HopLength samples from the previous one.
+	 The channels must be interleaved, since every hop is reduced on its own.
+	 @param[in] samples count*HopLength*NumberChannels samples following the ones pushed so far.
+	 @param[out] features Array of 3*count elements.
+	 @return An error description, or Q_NULLPTR on success.
+	 */
+	const char* processHops(const qint16* samples, int count, double* features);
+
+	/** Convert 16 bit samples to doubles in [-1,1] in a single vectorizable pass. */
+	static void convert(const qint16* in, int size, double* out);
+
+	/** Filtered time series of the last processed record. */
+	const QVector<double>& getTimeSeries() const {return filtered;};
+	/** Power spectrum of the last processed record. */
+	const QVector<double>& getSpectrum() const {return spectrum;};
+	/** Power spectrum without background of the last processed record. */
+	const QVector<double>& getCleanSpectrum() const {return cleanSpectrum;};
+	/** Spectrum bins of the formants of the last processed record. */
+	QVector<int> getFormants() const;
+
+private:
+	Parameters parameters;
+
+	QSharedPointer<UMF::ReduceChannels> channelsReduce;
+	QSharedPointer<UMF::Windowing> windowing;
+	QSharedPointer<UMF::GaussianFilter> gaussianFilter;
+	QSharedPointer<UMF::SpectrumMagnitude> spectrumMagnitude;
+	QSharedPointer<UMF::SpectrumRemoveBackground> backgroundRemove;
+
+	QVector<double> samples, reduced, filtered, spectrum, cleanSpectrum;
+	/** Filtered records and their spectra, for batch processing. */
+	QVector<double> batchFiltered, batchSpectra;
+	/** Reduced samples of the current overlapping record, the oldest one at ringHead. */
+	QVector<double> ring;
+	int ringHead;
+
+	/** Spectrum bins delimiting the three formant intervals. */
+	int binStart, binEnd, binStep;
+	int formants[3];
+	int numberFormants;
+
+	/** Convert and reduce length samples per channel, appending them to the ring buffer. */
+	void push(const qint16* samples, int length);
+
+	/** Make room for count filtered records and their spectra. */
+	void reserveBatch(int count);
+
+	/** Compute the spectra of count filtered records at once, followed by their features. */
+	const char* batchFeatures(int count, double* features);
+
+	/** Remove the background from a spectrum and compute the features of its record. */
+	const char* computeFeatures(const double* spectrum, double* features);
+};
+
+#endif /* RecordPipeline_hpp */
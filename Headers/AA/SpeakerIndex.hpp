@@ -0,0 +1,103 @@
+#ifndef SpeakerIndex_hpp
+#define SpeakerIndex_hpp
+
+#include <QVector>
+#include <limits>
+#include <vector>
+#include <AA/FeaturesSummary.hpp>
+#include <AA/PairwiseDistances.hpp>
+
+namespace AA {
+	class SpeakerIndex;
+}
+
+/** Index of the files of a database, to find the ones closest to a file without computing every distance.
+ The distance of AA::FeaturesDistance is the Mahalanobis distance between the weighted means of two files,
+ with the pooled covariance of both, hence the space changes with every pair. The index is a KD-tree over the
+ means whitened by the average covariance W of the database, and every node stores the largest eigenvalue of
+ the whitened covariances of its files. Since the pooled covariance is an average of the covariances of the two
+ files, or the identity when ill-conditioned, the distance from a query to any file of a node is at least
+ ||W(q-m)|| divided by the square root of the largest eigenvalue among the query and the node (whitened), where
+ m is the point of the node box closest to the query. The identity joins them unless the eigenvalues of the query
+ and of the node are close enough to rule out the regularization. Nodes whose bound exceeds the distance of
+ interest are skipped, so that the results are exact: they are the same of computing every distance.
+ Files whose covariance is not positive semidefinite, or without records, are kept out of the tree and always
+ compared; queries with such a covariance compare every file.
+ The leaves are contiguous ranges of files stored in the layout of AA::PairwiseDistances::Statistics, so that
+ their distances are computed by the vectorized kernel of AA::PairwiseDistances. Queries are const, and can be
+ made by any number of threads at once.
+ */
+class AA::SpeakerIndex {
+
+public:
+	/** A file of the database and its distance from the query. */
+	struct Neighbor {
+		/** Index of the file, in the order given to the constructor. */
+		int Index = -1;
+		double Distance = std::numeric_limits<double>::infinity();
+	};
+
+	SpeakerIndex() = default;
+
+	/** Build the index of the files with the given summaries, in O(N log N). */
+	explicit SpeakerIndex(const QVector<FeaturesSummary>& summaries);
+
+	int size() const {return statistics.size();};
+
+	/** The k files closest to the query, sorted by distance (and by index, for equal distances).
+	 Files whose distance is not a number are never returned.
+	 */
+	QVector<Neighbor> nearest(const FeaturesSummary& query, int k) const;
+
+	/** Files whose distance from the query is at most radius, in no particular order.
+	 @param[out] neighbors Replaced by the files found; reusing the same vector between queries avoids allocations.
+	 @return Number of files farther than radius (files whose distance is not a number are not counted).
+	 */
+	int withinRadius(const FeaturesSummary& query, double radius, QVector<Neighbor>& neighbors) const;
+
+private:
+	/** Node of the tree, with the files [Begin, End) of statistics. */
+	struct Node {
+		/** Bounding box of the whitened means. */
+		double Lower[2], Upper[2];
+		/** Largest eigenvalue of the whitened covariances of the files. */
+		double Spread;
+		/** Smallest and largest eigenvalues of the covariances of the files. */
+		double Smallest, Largest;
+		int Begin, End;
+		/** Children, or -1 for a leaf. */
+		int Left, Right;
+	};
+
+	/** Whitened query. */
+	struct Query {
+		double X, Y;
+		double Spread;
+		double Smallest, Largest;
+		bool Regular;
+	};
+
+	std::vector<Node> nodes;
+	/** Statistics of the files, in the order of the leaves; files [numberIndexed, size()) are out of the tree. */
+	PairwiseDistances::Statistics statistics;
+	/** Index given to the constructor of every file of statistics. */
+	QVector<int> order;
+	int numberIndexed = 0;
+	/** Lower triangular whitening matrix [w11 0; w21 w22]. */
+	double w11 = 1.0, w21 = 0.0, w22 = 1.0;
+	/** Largest eigenvalue of the whitened identity. */
+	double identitySpread = 1.0;
+
+	int build(std::vector<int>& files, int begin, int end, const std::vector<Query>& points);
+
+	Query whiten(const FeaturesSummary& summary) const;
+
+	/** Lower bound of the squared distance from the query to the files of a node. */
+	double bound(const Query& query, const Node& node) const;
+
+	/** Compute the distances from the query to the files [begin, end) and pass each one to visit(index, distance). */
+	template <typename Visitor>
+	void scan(const FeaturesSummary& query, int begin, int end, Visitor&& visit) const;
+};
+
+#endif /* SpeakerIndex_hpp */
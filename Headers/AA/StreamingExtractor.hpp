@@ -0,0 +1,85 @@
+#ifndef StreamingExtractor_hpp
+#define StreamingExtractor_hpp
+
+#include <QVector>
+#include <AA/FeaturesSummary.hpp>
+#include <AA/RecordPipeline.hpp>
+
+namespace AA {
+	class StreamingExtractor;
+}
+
+/** Push-based features extraction from a live audio source.
+ Interleaved 16 bit samples are pushed in chunks of any size, e.g. from an audio callback
+ or a pipe. Each record is processed as soon as its last sample arrives, so the latency is
+ bounded by the record length (by the hop length for overlapping records), and only the
+ samples of the incomplete record are kept.
+ The weighted statistics of the features are updated at every record, so that getSummary
+ gives in constant time the summary AA::FeaturesExtractor would compute on the samples
+ pushed so far, and AA::FeaturesDistance against the enrolled speakers can be updated
+ after every record. Until the spectral concentrations have a range (e.g. after a single
+ record, or during silence) the weights are undefined, and so are the means of the summary.
+ */
+class AA::StreamingExtractor {
+
+public:
+	/** @param[in] parameters Processing chain, as given by AA::FeaturesExtractor::getPipelineParameters. */
+	explicit StreamingExtractor(const RecordPipeline::Parameters& parameters);
+	StreamingExtractor(const StreamingExtractor&) = delete;
+	StreamingExtractor& operator=(const StreamingExtractor&) = delete;
+
+	/** Push interleaved samples.
+	 @param[in] samples Buffer of count samples; a chunk can end in the middle of a frame.
+	 @param[in] count Number of samples (all channels included).
+	 @param[out] features V1, V2 and the spectral concentration of every record completed by the
+	 chunk are appended to it. The spectral concentration is not normalized, since its range is
+	 only known at the end of the stream.
+	 @return An error description, or Q_NULLPTR on success.
+	 */
+	const char* push(const qint16* samples, qint64 count, QVector<double>& features);
+
+	/** Discard the pending samples and the statistics, to start a new stream. */
+	void reset();
+
+	/** Number of records extracted so far. */
+	int getRecords() const {return records;};
+
+	/** Samples between the beginnings of consecutive records. */
+	int getHopLength() const {return hopLength;};
+
+	/** Summary of the features extracted so far.
+	 The weights are normalized on the spectral concentrations seen so far, as
+	 AA::FeaturesExtractor does at the end of a file: when they are all equal the means
+	 (and the covariance, for more than one record) are NaN, as the ones of the extractor.
+	 */
+	FeaturesSummary getSummary() const;
+
+private:
+	RecordPipeline::Parameters parameters;
+	RecordPipeline pipeline;
+	int hopLength;
+
+	/** Samples of an incomplete hop, or of the beginning of the stream. */
+	QVector<qint16> pending;
+	qint64 pendingSize;
+	/** Whether the beginning of the first record has already been pushed to the pipeline. */
+	bool started;
+
+	int records;
+	/** Features of the first record, the origin of the moments. */
+	double origin[3];
+	/** Minimum and maximum spectral concentrations. */
+	double minimumWeight, maximumWeight;
+	/** Sums over the records of d^k*m, with d the spectral concentration relative to the origin,
+	 k = 0, 1, 2 and m = 1, x, y, x*x, x*y, y*y the monomials of the first two features relative to the origin.
+	 */
+	double moments[3][6];
+
+	/** Process count consecutive hops (or records) and accumulate their features. */
+	const char* process(const qint16* samples, int count, QVector<double>& features);
+
+	/** Add the features of a record to the moments. */
+	void accumulate(const double* features);
+};
+
+#endif /* StreamingExtractor_hpp */
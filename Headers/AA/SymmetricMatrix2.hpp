@@ -0,0 +1,56 @@
+#ifndef SymmetricMatrix2_hpp
+#define SymmetricMatrix2_hpp
+
+#include <algorithm>
+#include <cmath>
+
+namespace AA {
+	struct SymmetricMatrix2;
+}
+
+/** Symmetric 2x2 matrix [a b; b c] with closed-form kernels.
+ The distance between two files needs the condition number and the inverse of a 2x2
+ covariance matrix for every pair: the closed forms avoid the dispatch of the general
+ Armadillo/LAPACK routines and contain no branches, so that loops over many matrices
+ can be vectorized by the compiler.
+ */
+struct AA::SymmetricMatrix2 {
+	double a = 1.0;
+	double b = 0.0;
+	double c = 1.0;
+	
+	/** Average of two matrices weighted by the given counts. */
+	static SymmetricMatrix2 pooled(double countA, const SymmetricMatrix2& A, double countB, const SymmetricMatrix2& B){
+		const double count = countA + countB;
+		return {(countA * A.a + countB * B.a) / count, (countA * A.b + countB * B.b) / count, (countA * A.c + countB * B.c) / count};
+	}
+	
+	double determinant() const {return a * c - b * b;};
+	
+	/** Norm 1, i.e. the maximum absolute column sum. */
+	double norm1() const {return std::max(std::abs(a) + std::abs(b), std::abs(b) + std::abs(c));};
+	
+	/** Reciprocal condition number in norm 1, the quantity estimated by arma::rcond.
+	 Since the inverse is [c -b; -b a]/det, its norm 1 is norm1()/|det|. The result is
+	 not a number for the null matrix.
+	 */
+	double rcond() const {
+		const double norm = norm1();
+		return std::abs(determinant()) / (norm * norm);
+	};
+	
+	/** The matrix itself, or the identity if its reciprocal condition number is lower than minimum
+	 (or not a number, like Armadillo reporting a null condition for a null matrix).
+	 */
+	SymmetricMatrix2 regularized(double minimum) const {
+		const bool identity = !(rcond() >= minimum);
+		return {identity ? 1.0 : a, identity ? 0.0 : b, identity ? 1.0 : c};
+	};
+	
+	/** Quadratic form of the inverse matrix, v * inv(M) * v' with v = [x y]. */
+	double inverseQuadraticForm(double x, double y) const {
+		return (c * x * x - 2.0 * b * x * y + a * y * y) / determinant();
+	};
+};
+
+#endif /* SymmetricMatrix2_hpp */
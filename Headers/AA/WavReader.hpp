@@ -0,0 +1,87 @@
+#ifndef WavReader_hpp
+#define WavReader_hpp
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+namespace AA {
+	class WavReader;
+}
+
+/** Reader of RIFF/WAVE files with PCM samples.
+ The reader parses the file header and decodes 8, 16, 24 and 32 bit PCM samples
+ (also when stored with the WAVE_FORMAT_EXTENSIBLE tag) to interleaved 16 bit samples,
+ with the same conversion performed by SFML. It relies on no global state: each
+ instance owns its file handle and decoding buffer, so that any number of files can be
+ opened and decoded concurrently by different threads.
+ The data chunk is memory mapped whenever possible: 16 bit samples are then accessed
+ through view without being copied, and no system call is needed to get a record.
+ When mapping is not available the reader falls back to buffered reads.
+ */
+class AA::WavReader {
+
+public:
+	WavReader() = default;
+	WavReader(const WavReader&) = delete;
+	WavReader& operator=(const WavReader&) = delete;
+
+	/** Open a file and parse its header.
+	 @return false if the file cannot be opened or is not supported; the reason is given by getError.
+	 */
+	bool open(const QString& fileName);
+
+	/** Description of the last error. */
+	QString getError() const {return error;};
+
+	unsigned int getSampleRate() const {return sampleRate;};
+	unsigned int getChannelCount() const {return channelCount;};
+	/** Total number of samples in the file (all channels included). */
+	qint64 getSampleCount() const {return sampleCount;};
+
+	/** Whether the samples are memory mapped. */
+	bool isMapped() const {return mapped != Q_NULLPTR;};
+
+	/** Get a range of interleaved samples without changing the current reading position.
+	 16 bit samples of a mapped file are returned in place, other formats are decoded
+	 into an internal buffer. The pointer is valid until the next call to view, read or
+	 open, or until the reader is destroyed.
+	 @param[in] sampleOffset Index of the first sample, counting the samples of every channel.
+	 @param[in] count Number of samples (all channels included).
+	 @return Pointer to count samples, or Q_NULLPTR if the range exceeds the file.
+	 */
+	const qint16* view(qint64 sampleOffset, qint64 count);
+
+	/** Change the current reading position.
+	 @param[in] sampleOffset Index of the sample to jump to, counting the samples of every channel.
+	 */
+	void seek(qint64 sampleOffset);
+
+	/** Read interleaved samples from the current position.
+	 @param[out] samples Buffer with at least maxCount elements.
+	 @param[in] maxCount Maximum number of samples to read (all channels included).
+	 @return Number of samples actually read.
+	 */
+	qint64 read(qint16* samples, qint64 maxCount);
+
+private:
+	QFile file;
+	QString error;
+	unsigned int sampleRate = 0;
+	unsigned int channelCount = 0;
+	unsigned int bytesPerSample = 0;
+	qint64 sampleCount = 0;
+	qint64 dataOffset = 0;
+	qint64 position = 0;
+	uchar* mapped = Q_NULLPTR;
+	QByteArray buffer;
+	QVector<qint16> scratch;
+
+	bool fail(const QString& description);
+
+	/** Convert raw little-endian samples to 16 bit ones. */
+	void decode(const uchar* raw, qint64 count, qint16* samples) const;
+};
+
+#endif /* WavReader_hpp */
@@ -11,6 +11,7 @@
 #include <UMF/ComputeHistogram.hpp>
 #include <UMF/CurveNormalization.hpp>
 #include <UMF/Evaluate1D.hpp>
+#include <AA/DatabaseFile.hpp>
 #include <AA/FeaturesExtractor.hpp>
 
 namespace GUI{
@@ -39,6 +40,18 @@ namespace GUI{
 		CurveType m_Type = GaussianExp;
 		QVector<double> m_Coefficients = {5.0, 0.3, 0.1, 0.1};
 		QList<QVector<double>> m_Features;
+		QVector<AA::FeaturesSummary> m_Summaries;
+		QVector<int> m_Groups;
+		QStringList m_FileNames;
+		/** Database the files are read from, when loaded from a file, and the range of its files; the files added later follow them. */
+		QSharedPointer<const AA::DatabaseFile> m_Database;
+		int m_FirstFile = 0;
+		int m_NumberFiles = 0;
+		/** Histogram of the distances the curve was fitted to, with the bins of AA::PairwiseDistances, to enroll more files. */
+		double m_HistogramMinimum = 0.0;
+		double m_HistogramMaximum = 0.0;
+		double m_BarStep = 0.0;
+		QVector<double> m_Counts;
 		
 	public:
 		DatabaseLine(QObject* parente = Q_NULLPTR);
@@ -48,15 +61,39 @@ namespace GUI{
 		int getNumPoints() const {return m_NumPoints;};
 		CurveType getType() const {return m_Type;};
 		QVector<double> getCoefficients() const {return m_Coefficients;};
-		QList<QVector<double>> getFeatures() const {return m_Features;};
+		/** Features of every file; when the line is loaded from a database they are copied out of it. */
+		QList<QVector<double>> getFeatures() const;
+		/** Summaries of the features, in the same order; they are computed when the features are set. */
+		QVector<AA::FeaturesSummary> getSummaries() const;
+		/** Group (speaker) of every file, in the same order. */
+		QVector<int> getGroups() const;
+		QStringList getFileNames() const;
+		int getNumberFiles() const {return (m_Database ? m_NumberFiles : 0) + m_Features.size();};
+		/** Every file, with the features referring to the line or to the mapped database, without copies. */
+		QVector<AA::DatabaseFile::File> getFiles() const;
+		double getHistogramMinimum() const {return m_HistogramMinimum;};
+		double getHistogramMaximum() const {return m_HistogramMaximum;};
+		double getBarStep() const {return m_BarStep;};
+		/** Number of distances in every bin of the histogram, empty if unknown (e.g. loaded from an old database). */
+		QVector<double> getCounts() const {return m_Counts;};
 		
 		void setMinimum(double min){m_Minimum=min; update(); Q_EMIT parameterChanged();};
 		void setMaximum(double max){m_Maximum=max; update(); Q_EMIT parameterChanged();};
 		void setNumPoints(int n_points){m_NumPoints=n_points; update(); Q_EMIT parameterChanged();};
 		void setType(CurveType type){m_Type=type; update(); Q_EMIT parameterChanged();};
 		void setCoefficients(QVector<double> coeff){m_Coefficients=coeff; update(); Q_EMIT parameterChanged();};
-		void setFeatures(QList<QVector<double>> features){m_Features=features; Q_EMIT featuresChanged();};
-		void addFeatures(QVector<double> features){m_Features << features; Q_EMIT featuresChanged();};
+		void setFeatures(QList<QVector<double>> features);
+		void addFeatures(QVector<double> features){addFeatures(features, AA::FeaturesSummary::fromFeatures(features));};
+		void addFeatures(QVector<double> features, AA::FeaturesSummary summary, int group = 0, QString fileName = QString());
+		/** Read the files of the line from a database, in place.
+		 @param[in] first,count Range of the files of the database.
+		 */
+		void setDatabase(QSharedPointer<const AA::DatabaseFile> database, int first, int count);
+		/** Set the histogram the curve was fitted to.
+		 @param[in] minimum,maximum,step Bins, as the parameters of AA::PairwiseDistances.
+		 @param[in] counts Number of distances in every bin, as given by AA::PairwiseDistances.
+		 */
+		void setHistogram(double minimum, double maximum, double step, QVector<double> counts);
 		
 		static QVector<double> linspace(double min, double max, int points);
 		static QVector<double> regspace(double min, double max, double step);
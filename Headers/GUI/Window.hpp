@@ -13,6 +13,7 @@
 #include <QSharedPointer>
 #include <QDir>
 #include <QVector>
+#include <QSet>
 // Other libraries
 #include <ui_Window.h>
 #include <QAlgorithm.hpp>
@@ -21,6 +22,8 @@
 #include <UMF/CurveNormalization.hpp>
 #include <AA/ComputeProbability.hpp>
 #include <AA/FeaturesDistance.hpp>
+#include <AA/PairwiseDistances.hpp>
+#include <AA/SpeakerIndex.hpp>
 #include <GUI/DatabaseChart.hpp>
 #include <GUI/ScanDirectory.hpp>
 #include <GUI/savewindow.hpp>
@@ -68,6 +71,19 @@ private:
 	
 	QAlgorithm::PropertyMap getPropsInGroup(const QString& group);
 	
+	/** Load the curves of a database file, with their files read in place from the mapped file.
+	 Files saved by previous versions, as streams of two lines and of the settings, are read too.
+	 @param[in] loadSettings Whether the settings stored in the file replace the current ones.
+	 @return The lines, or an empty list if the file cannot be read (the error is shown).
+	 */
+	QList<GUI::DatabaseLine*> loadDatabase(const QString& fileName, bool loadSettings);
+	
+	/** Extract the files of the chosen folder and fit the distributions of their distances.
+	 Given the lines of a database, its files are skipped and the new ones are added to the lines: only the
+	 distances involving a new file are computed, added to the histograms of the lines, and fitted again.
+	 */
+	void createDatabase(GUI::DatabaseLine* intraLine = Q_NULLPTR, GUI::DatabaseLine* extraLine = Q_NULLPTR);
+	
 	void setupSettingsTab();
 	
 	void resizeEvent(QResizeEvent *event);
@@ -93,6 +109,11 @@ private:
 	 Computes the distances between every pair of feature vectors.
 	 */
 	Q_SLOT void on_DBCreateButton_clicked();
+	
+	/** Add to database button callback.
+	 Adds the new files of the chosen folder to the database lines with the given name.
+	 */
+	Q_SLOT void on_DBEnrollButton_clicked();
 		
 	/** Save the database to file. */
 	Q_SLOT void on_DBSaveButton_clicked();
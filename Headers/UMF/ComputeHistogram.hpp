@@ -2,12 +2,18 @@
 #define ComputeHistogram_hpp
 
 #include <QAlgorithm.hpp>
-#include <armadillo>
+#include <UMF/HistogramAccumulator.hpp>
 
 namespace UMF {
 	class ComputeHistogram;
 }
 
+/** Histogram of a set of values.
+ The bins have width BarStep, the first one starts at MinimumValue and the last one contains
+ the largest value, or MaximumValue if lower; values out of range are discarded. The values are
+ binned in a single pass by UMF::HistogramAccumulator, that can also be used directly to bin
+ values as they are produced, without storing them.
+ */
 class UMF::ComputeHistogram : public QAlgorithm {
 	
 	Q_OBJECT
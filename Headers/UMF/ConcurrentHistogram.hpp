@@ -0,0 +1,44 @@
+#ifndef ConcurrentHistogram_hpp
+#define ConcurrentHistogram_hpp
+
+#include <UMF/HistogramAccumulator.hpp>
+#include <vector>
+
+namespace UMF {
+	class ConcurrentHistogram;
+}
+
+/** Histogram filled concurrently by several threads.
+ Each thread fills its own shard, a UMF::HistogramAccumulator aligned to a cache line, so that
+ threads never write to the same line and no lock or atomic operation is needed: the throughput
+ scales with the number of threads. The shards are summed when the histogram is read.
+ Shards are identified by the worker index given by UMF::parallelFor.
+ */
+class UMF::ConcurrentHistogram {
+
+public:
+	/** Create a histogram with the bins of UMF::HistogramAccumulator and the given number of shards. */
+	ConcurrentHistogram(double minimum, double maximum, double step, int numberShards);
+
+	int getNumberShards() const {return int(shards.size());};
+
+	/** Shard of a worker; it must be filled by one thread at a time. */
+	HistogramAccumulator& shard(int worker){return shards[worker].histogram;};
+
+	/** Count a value in the shard of a worker. */
+	void add(int worker, double value){shard(worker).add(value);};
+
+	/** Sum of the shards; it must not be called while the shards are being filled. */
+	HistogramAccumulator merged() const;
+
+	/** Reset the counts of every shard. */
+	void clear();
+
+private:
+	struct alignas(64) Shard {
+		HistogramAccumulator histogram;
+	};
+	std::vector<Shard> shards;
+};
+
+#endif /* ConcurrentHistogram_hpp */
@@ -2,7 +2,6 @@
 #define CurveNormalization_hpp
 
 #include <QAlgorithm.hpp>
-#include <UMF/Evaluate1D.hpp>
 #include <armadillo>
 #include <alglib/integration.h>
 
@@ -10,13 +9,25 @@ namespace UMF {
 	class CurveNormalization;
 }
 
+/** Scale a fitted curve to unit integral over [LeftExtremum, RightExtremum].
+ The integrals are computed in closed form, falling back to adaptive quadrature where the closed form
+ would lose accuracy to cancellation.
+ */
 class UMF::CurveNormalization : public QAlgorithm {
 	
 	Q_OBJECT
 	
+public:
+	enum model{
+		gaussExp,	// UMF::EvaluateGaussExp
+		gauss		// UMF::EvaluateGauss
+	};
+	Q_ENUM(model)
+	
 	QA_INPUT(QVector<double>, Coefficients)
 	QA_PARAMETER(double, LeftExtremum, 0.0)
 	QA_PARAMETER(double, RightExtremum, 1.0)
+	QA_PARAMETER(int, Model, gaussExp)
 	QA_OUTPUT(QVector<double>, Coefficients)
 	
 	QA_CTOR_INHERIT
@@ -24,6 +35,12 @@ class UMF::CurveNormalization : public QAlgorithm {
 	
 public:
 	void run();
+	
+	/** Integral of a model with coefficients C over [left, right]. */
+	static double integral(int model, const QVector<double>& C, double left, double right);
+	
+	/** The same integral by the adaptive Gauss-Kronrod quadrature of ALGLIB, evaluating the model kernel. */
+	static double adaptiveIntegral(int model, const QVector<double>& C, double left, double right);
 };
 
 #endif /* CurveNormalization_hpp */
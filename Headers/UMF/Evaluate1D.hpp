@@ -8,6 +8,7 @@
 #include <cmath>
 #include <QAlgorithm.hpp>
 #include <UMF/CurveNormalization.hpp>
+#include <UMF/FastMath.hpp>
 
 namespace UMF {
 	
@@ -23,14 +24,22 @@ namespace UMF {
 		
 	public:
 		typedef void(*EvalFuncType)(const alglib::real_1d_array&, const alglib::real_1d_array&, double&, void*);
+		/** Function and its gradient with respect to the coefficients, in the form required by ALGLIB. */
+		typedef void(*GradFuncType)(const alglib::real_1d_array&, const alglib::real_1d_array&, double&, alglib::real_1d_array&, void*);
+		/** Kernel evaluating the function with coefficients C at the size points of X. */
+		typedef void(*BatchFuncType)(const double* C, const double* X, qint64 size, double* Y);
 		
 	protected:
 		EvalFuncType eval = Q_NULLPTR;
+		GradFuncType gradient = Q_NULLPTR;
+		BatchFuncType batch = Q_NULLPTR;
 		
 	public:
 		void run() final;
 		
 		EvalFuncType getInternalFunc() const {return eval;};
+		GradFuncType getGradientFunc() const {return gradient;};
+		BatchFuncType getBatchFunc() const {return batch;};
 		
 		QVector<double> evaluate(QVector<double> C,
 								 QVector<double> X);
@@ -46,6 +55,18 @@ namespace UMF {
 		using Evaluate1D::Evaluate1D;
 		
 		void init();
+		
+		/** nu * Phi((x-mu)/sigma) * exp(-x/tau), with C = {nu, mu, sigma, tau} and Phi the normal
+		 distribution function, computed by UMF::FastMath (relative error below 4e-15 for x >= mu-3*sigma,
+		 where the ALGLIB evaluation is less accurate).
+		 */
+		static void kernel(const double* C, const double* X, qint64 size, double* Y);
+		
+		/** Integral over [left, right], in closed form (by parts, completing the square in the exponent).
+		 @return NaN when the closed form loses more than three digits to cancellation, i.e. when tau is
+		 much larger than the interval, or the interval is far in the lower tail.
+		 */
+		static double integral(const double* C, double left, double right);
 	};
 	
 	class EvaluateGauss : public Evaluate1D {
@@ -58,6 +79,13 @@ namespace UMF {
 		using Evaluate1D::Evaluate1D;
 		
 		void init();
+		
+		/** c0 * exp(-(x-c1)^2 / (2*c2^2)), computed by UMF::FastMath (within 1 ulp of std::exp).
+		 */
+		static void kernel(const double* C, const double* X, qint64 size, double* Y);
+		
+		/** Integral over [left, right], in closed form, for c2 > 0. */
+		static double integral(const double* C, double left, double right);
 	};
 	
 	class Fitting1D : public QAlgorithm {
@@ -74,6 +102,8 @@ namespace UMF {
 		
 	protected:
 		QSharedPointer<Evaluate1D> evaluator;
+		/** Model of UMF::CurveNormalization for the fitted curve. */
+		int model = CurveNormalization::gaussExp;
 		
 	public:
 		void run();
@@ -0,0 +1,88 @@
+#ifndef HistogramAccumulator_hpp
+#define HistogramAccumulator_hpp
+
+#include <QVector>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace UMF {
+	class HistogramAccumulator;
+}
+
+/** Histogram with fixed bins, filled one value at a time.
+ Values are binned as soon as they are produced, in any order, so that the memory needed is
+ proportional to the number of bins rather than to the number of values. The bins have width
+ step, the first one starts at minimum and the last one contains maximum; values out of
+ [minimum, maximum] only contribute to the total. Instances filled by different threads with
+ the same bins are merged by summing them.
+ */
+class UMF::HistogramAccumulator {
+
+public:
+	HistogramAccumulator() = default;
+
+	HistogramAccumulator(double minimum, double maximum, double step);
+
+	/** Count a value. */
+	void add(double value){
+		++total;
+		largest = std::max(largest, value);
+		if (value >= minimum && value <= maximum)
+			++bins[int((value - minimum) / step)];
+	}
+
+	/** Count an array of values. */
+	void add(const double* values, qint64 count){
+		// The largest value is kept in a register, and the total is updated once
+		double top = largest;
+		qint64* counts = bins.data();
+		for (qint64 k = 0; k < count; ++k){
+			const double value = values[k];
+			top = std::max(top, value);
+			if (value >= minimum && value <= maximum)
+				++counts[int((value - minimum) / step)];
+		}
+		largest = top;
+		total += count;
+	}
+
+	/** Sum the counts of another histogram with the same bins. */
+	HistogramAccumulator& operator+=(const HistogramAccumulator& other);
+
+	/** Add the counts of a histogram with the same bins, e.g. stored by a previous run as given by getCounts.
+	 The total grows by their sum; the largest value is not known, so it is unchanged.
+	 @return false, leaving the histogram unchanged, if their number is not the number of bins.
+	 */
+	bool addCounts(const QVector<double>& counts);
+
+	/** Reset the counts, keeping the bins. */
+	void clear();
+
+	int getNumberBins() const {return int(bins.size());};
+	/** Number of values in each bin. */
+	const std::vector<qint64>& getBins() const {return bins;};
+	/** Number of values in each bin, empty ones included, to be stored and added back by addCounts. */
+	QVector<double> getCounts() const;
+	/** Number of values added, including the ones out of range. */
+	qint64 getTotal() const {return total;};
+	/** Largest value added, including the ones out of range. */
+	double getLargest() const {return largest;};
+
+	/** Get the bin centers and the corresponding counts.
+	 @param[in] suppressZeroCount Whether to skip the empty bins.
+	 @param[in] cropToLargest Whether to end with the bin containing the largest value added (or maximum,
+	 if lower), as UMF::ComputeHistogram does, rather than with the one containing maximum.
+	 */
+	void getHistogram(QVector<double>& X, QVector<double>& Y, bool suppressZeroCount, bool cropToLargest = false) const;
+
+private:
+	double minimum = 0.0;
+	double maximum = -1.0;
+	double step = 1.0;
+	std::vector<qint64> bins;
+	qint64 total = 0;
+	double largest = -std::numeric_limits<double>::infinity();
+};
+
+#endif /* HistogramAccumulator_hpp */
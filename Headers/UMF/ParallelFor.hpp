@@ -0,0 +1,85 @@
+#ifndef ParallelFor_hpp
+#define ParallelFor_hpp
+
+#include <QThread>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace UMF {
+
+	/** Process the range [first, last) on a pool of threads with work stealing.
+	 The range is split evenly among the workers, and each worker processes its own
+	 part in chunks of grain items, calling body(begin, end, worker) for each chunk.
+	 When a worker runs out of items it steals half of the items left to another worker,
+	 so that an unbalanced load (e.g. records of very different cost) keeps every thread busy.
+	 The calling thread takes part in the computation as worker 0, and the function returns
+	 when the whole range has been processed.
+	 @param[in] threads Number of workers; values lower than 1 select the number of available cores.
+	 */
+	template <typename Body>
+	void parallelFor(int first, int last, int grain, int threads, Body&& body){
+		if (last <= first) return;
+		if (threads < 1) threads = QThread::idealThreadCount();
+		grain = std::max(grain, 1);
+		threads = std::max(1, std::min(threads, (last - first + grain - 1) / grain));
+		if (threads == 1){
+			for (int begin = first; begin < last; begin += grain)
+				body(begin, std::min(begin + grain, last), 0);
+			return;
+		}
+		// Each range is packed in a single atomic word (begin in the upper half, end in the lower one),
+		// so that the owner and the thieves can both update it with a compare-and-swap.
+		// Ranges are aligned to cache lines to avoid false sharing.
+		struct alignas(64) Range {
+			std::atomic<std::uint64_t> bounds;
+		};
+		auto pack = [](std::uint32_t begin, std::uint32_t end){ return (std::uint64_t(begin) << 32) | end; };
+		std::vector<Range> ranges(threads);
+		const std::int64_t size = last - first;
+		for (int w = 0; w < threads; ++w){
+			auto begin = std::uint32_t(first + size * w / threads);
+			auto end = std::uint32_t(first + size * (w + 1) / threads);
+			ranges[w].bounds.store(pack(begin, end));
+		}
+		auto worker = [&](int w){
+			auto& own = ranges[w].bounds;
+			while (true){
+				// Take a chunk from the front of the own range
+				auto bounds = own.load();
+				std::uint32_t begin = bounds >> 32, end = std::uint32_t(bounds);
+				if (begin < end){
+					std::uint32_t next = std::min(begin + std::uint32_t(grain), end);
+					if (own.compare_exchange_weak(bounds, pack(next, end)))
+						body(int(begin), int(next), w);
+					continue;
+				}
+				// Steal the back half of the largest range left
+				int victim = -1;
+				std::uint32_t largest = 1;
+				for (int v = 0; v < threads; ++v){
+					auto other = ranges[v].bounds.load();
+					std::uint32_t left = std::uint32_t(other >> 32), right = std::uint32_t(other);
+					if (v != w && left < right && right - left > largest){
+						largest = right - left;
+						victim = v;
+					}
+				}
+				if (victim < 0) return; // nothing left worth stealing
+				auto other = ranges[victim].bounds.load();
+				std::uint32_t left = std::uint32_t(other >> 32), right = std::uint32_t(other);
+				if (left >= right || right - left < 2) continue;
+				std::uint32_t middle = left + (right - left) / 2;
+				if (ranges[victim].bounds.compare_exchange_strong(other, pack(left, middle)))
+					own.store(pack(middle, right));
+			}
+		};
+		std::vector<std::thread> pool;
+		for (int w = 1; w < threads; ++w) pool.emplace_back(worker, w);
+		worker(0);
+		for (auto& thread: pool) thread.join();
+	}
+}
+
+#endif /* ParallelFor_hpp */
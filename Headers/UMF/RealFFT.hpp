@@ -0,0 +1,84 @@
+#ifndef RealFFT_hpp
+#define RealFFT_hpp
+
+#include <QSharedPointer>
+#include <QVector>
+
+namespace UMF {
+	class RealFFT;
+}
+
+/** Plan of the discrete Fourier transform of real signals whose length is a power of two.
+ The signal of N samples is packed into a complex signal of N/2 samples (even samples as
+ real parts, odd samples as imaginary parts), which is transformed by an iterative radix-2
+ FFT; the spectrum of the real signal is then recovered with a final split pass.
+ Bit reversal indices and twiddle factors are computed once, when the plan is created,
+ and stored stage by stage so that each butterfly loop reads them contiguously.
+ Complex values are kept as separate arrays of real and imaginary parts, which the
+ compiler vectorizes without intrinsics.
+ A plan is immutable: the same instance can be used concurrently by any number of threads,
+ each with its own output arrays. Plans are shared through a cache, see plan.
+ */
+class UMF::RealFFT {
+
+public:
+	/** Get the plan for signals of the given length, creating it on first use.
+	 @return A null pointer if the length is not supported (see supports).
+	 */
+	static QSharedPointer<const RealFFT> plan(int size);
+
+	/** Whether the length is a power of two, at least 4. */
+	static bool supports(int size) {return size >= 4 && (size & (size - 1)) == 0;};
+
+	int size() const {return N;};
+
+	/** Compute the non-negative frequency half of the spectrum of a real signal.
+	 @param[in] in Signal with size elements.
+	 @param[out] re Real parts of the size/2+1 frequency bins.
+	 @param[out] im Imaginary parts of the size/2+1 frequency bins.
+	 */
+	void forward(const double* in, double* re, double* im) const;
+
+	/** Compute a real signal from the non-negative frequency half of its spectrum.
+	 This is the inverse of forward, normalization included.
+	 @param[in,out] re Real parts of the size/2+1 frequency bins, overwritten.
+	 @param[in,out] im Imaginary parts of the size/2+1 frequency bins, overwritten.
+	 @param[out] out Signal with size elements.
+	 */
+	void inverse(double* re, double* im, double* out) const;
+
+	/** Compute the squared magnitude of count bins multiplied by factor. */
+	static void power(const double* re, const double* im, int count, double factor, double* out);
+
+	/** Number of records transformed together by powerBatch, one per SIMD lane. */
+	static const int batchWidth = 4;
+
+	/** Compute the power spectra of several records at once.
+	 Records are processed in groups of batchWidth: the samples of a group are interleaved
+	 so that every butterfly operates on the same sample of each record, and the innermost
+	 loops (over the records) map onto SIMD lanes. The twiddle factors are thus loaded once
+	 per group instead of once per record.
+	 @param[in] in count records of size elements each, laid out contiguously.
+	 @param[in] factor Factor applied to the squared magnitudes.
+	 @param[out] out count power spectra of size/2+1 elements each, laid out contiguously.
+	 @param[in,out] workspace Buffer resized as needed, to be kept between calls.
+	 */
+	void powerBatch(const double* in, int count, double factor, double* out, QVector<double>& workspace) const;
+
+private:
+	explicit RealFFT(int size);
+
+	/** Butterfly stages of the complex FFT of N/2 samples, given in bit reversed order. */
+	void butterflies(double* re, double* im) const;
+
+	/** Length of the real signal. */
+	int N;
+	/** Bit reversal permutation of the N/2 complex samples. */
+	QVector<int> reversed;
+	/** Twiddle factors of the stages, the one with h butterflies per block starting at h-1. */
+	QVector<double> stageRe, stageIm;
+	/** Twiddle factors of the split pass, exp(-2 pi i k/N) for k up to N/4. */
+	QVector<double> splitRe, splitIm;
+};
+
+#endif /* RealFFT_hpp */
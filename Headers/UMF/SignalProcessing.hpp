@@ -2,8 +2,7 @@
 #define SignalProcessing_hpp
 
 #include <QAlgorithm.hpp>
-#include <TSpectrum.h>
-#include <TMath.h>
+#include <UMF/RealFFT.hpp>
 #include <alglib/fasttransforms.h>
 #include <armadillo>
 
@@ -35,6 +34,13 @@ namespace UMF {
 		
 	public:
 		void run();
+		
+		/** Reduce the channels of a raw buffer.
+		 @param[in] in Samples of every channel, arranged as specified by ChannelsArrangement.
+		 @param[in] inputSize Number of elements in in.
+		 @param[out] out Reduced signal, with inputSize/NumberChannels elements.
+		 */
+		void apply(const double* in, int inputSize, double* out);
 	};
 	
 	class Windowing : public QAlgorithm {
@@ -62,6 +68,9 @@ namespace UMF {
 		void run();
 		
 		void init();
+		
+		/** Multiply in place a raw buffer of Length elements by the window. */
+		void apply(double* signal) const;
 	};
 	
 	class ArrayPad : public QAlgorithm {
@@ -107,6 +116,27 @@ namespace UMF {
 		int borderInterpolate(const int& pos,
 							  const int& len,
 							  const border_type& bd);
+		
+		/** Pad a raw buffer.
+		 The output buffer must have size+2*radius elements. Unlike run, no fallback
+		 to the constant border is performed when the signal is too short.
+		 @return false if the border type is not recognized.
+		 */
+		static bool pad(const double* in,
+						int size,
+						int radius,
+						int borderType,
+						double* out);
+		
+		/** Value at a position of the padded signal, without building it.
+		 The value is the one that pad would put at index pos+radius of its output,
+		 for any radius up to size (or up to size-1 with reflect_101).
+		 @param[in] pos Position relative to the first sample, possibly out of [0, size).
+		 */
+		static double extrapolate(const double* in,
+								  int size,
+								  int pos,
+								  int borderType);
 	};
 	
 	class GaussianFilter : public QAlgorithm {
@@ -130,15 +160,47 @@ namespace UMF {
 		
 		void run();
 		
+		/** Filter a raw buffer of size elements into out.
+		 Small radii are convolved directly: the border mode is applied virtually, on
+		 two short buffers holding the samples around the borders, while the inner samples
+		 are read straight from the input; several outputs are computed at once to exploit
+		 SIMD instructions, with the products accumulated in order. Up to 32 taps (Radius < 16)
+		 that is the order of Armadillo's conv, and the result is the same bit for bit; for
+		 longer kernels conv takes each dot product from BLAS (ddot, in BLAS-enabled builds),
+		 whose summation order is its own, so the results may differ by rounding.
+		 From fftRadius on, the convolution is computed in the frequency domain with
+		 UMF::RealFFT, whose cost does not depend on the radius; the result differs from the
+		 direct one by rounding only. Buffers and the spectrum of the kernel are kept between
+		 calls, so that filtering signals of the same length does not allocate memory.
+		 */
+		void apply(const double* in, int size, double* out);
+		
+		/** Smallest radius convolved in the frequency domain. */
+		static const int fftRadius = 64;
+		
 	private:
 		arma::vec kernel;
+		QVector<double> padded, edge;
+		/** Plan and real spectrum of the kernel for the frequency domain convolution. */
+		QSharedPointer<const RealFFT> fft;
+		QVector<double> kernelSpectrum, dftRe, dftIm;
+		
+		/** Direct convolution of count outputs, the n-th one using x[n], ..., x[n+2*Radius]. */
+		void convolve(const double* x, int count, double* out) const;
+		
+		/** Convolution in the frequency domain. */
+		void convolveFFT(const double* in, int size, int borderType, double* out);
 	};
 	
 	class SpectrumMagnitude : public QAlgorithm {
 		
 		Q_OBJECT
 		
+		/** Signals (e.g. windowed records) of the same length, laid out contiguously. */
 		QA_INPUT(QVector<double>, Signal)
+		/** Number of signals in the input. */
+		QA_PARAMETER(int, NumberRecords, 1)
+		/** Power spectra of the signals, laid out contiguously. */
 		QA_OUTPUT(QVector<double>, Signal)
 		
 		QA_CTOR_INHERIT
@@ -146,6 +208,29 @@ namespace UMF {
 		
 	public:
 		void run();
+		
+		/** Compute the power spectrum of a raw buffer.
+		 Lengths that are powers of two are transformed by UMF::RealFFT, unless the
+		 library is built with the ALGLIB backend (UMF_FFT_ALGLIB defined); any other
+		 length is transformed by ALGLIB. The buffers are kept between calls.
+		 @param[in] in Signal with size elements.
+		 @param[out] out Power spectrum, with size/2+1 elements.
+		 */
+		void apply(const double* in, int size, double* out);
+		
+		/** Compute the power spectra of count signals of size elements.
+		 Lengths that are powers of two are transformed together, see UMF::RealFFT::powerBatch,
+		 the others one at a time.
+		 @param[in] in Signals laid out contiguously.
+		 @param[out] out Power spectra of size/2+1 elements, laid out contiguously.
+		 */
+		void applyBatch(const double* in, int size, int count, double* out);
+		
+	private:
+		QSharedPointer<const RealFFT> fft;
+		QVector<double> dftRe, dftIm, workspace;
+		alglib::real_1d_array signal;
+		alglib::complex_1d_array dft;
 	};
 	
 	class SpectrumRemoveBackground : public QAlgorithm {
@@ -177,12 +262,18 @@ namespace UMF {
 		Q_ENUM(smoothingWindow)
 		
 		QA_INPUT(QVector<double>, Signal)
+		/** Maximum half width of the clipping window. */
 		QA_PARAMETER(int, NumberIterations, 6)
-		QA_PARAMETER(int, Direction, TSpectrum::kBackIncreasingWindow)
-		QA_PARAMETER(int, FilterOrder, TSpectrum::kBackOrder2)
-		QA_PARAMETER(bool, Smoothing, kFALSE)
-		QA_PARAMETER(int, SmoothWindow, TSpectrum::kBackSmoothing3)
-		QA_PARAMETER(bool, Compton, kFALSE)
+		/** Whether the clipping window widens or narrows at each iteration. */
+		QA_PARAMETER(int, Direction, kBackIncreasingWindow)
+		/** Order of the clipping filter. */
+		QA_PARAMETER(int, FilterOrder, kBackOrder2)
+		/** Whether comparing local averages instead of single bins. */
+		QA_PARAMETER(bool, Smoothing, false)
+		/** Width of the local averages. */
+		QA_PARAMETER(int, SmoothWindow, kBackSmoothing3)
+		/** Whether estimating the Compton edges. */
+		QA_PARAMETER(bool, Compton, false)
 		QA_OUTPUT(QVector<double>, Signal)
 		
 		QA_CTOR_INHERIT
@@ -192,6 +283,29 @@ namespace UMF {
 		void run();
 		
 		void init();
+		
+		/** Remove the background from a raw buffer of size elements.
+		 @return An error description, or Q_NULLPTR on success.
+		 */
+		const char* apply(const double* in, int size, double* out);
+		
+		/** Estimate the background of a raw buffer of size elements.
+		 The background is estimated with the SNIP (Sensitive Nonlinear Iterative Peak)
+		 clipping algorithm, as done by TSpectrum::Background of ROOT, whose error messages
+		 are reproduced, and whose results too, except with smoothing at filter orders 6 and 8:
+		 there ROOT combines the averaged bins with coefficients that are not symmetric around
+		 the bin, unlike its own unsmoothed filter, which shifts the estimate; the symmetric
+		 coefficients of the unsmoothed filter are used instead.
+		 At each iteration every bin is replaced by the minimum of its value and of an
+		 estimate from the bins at the distance given by the clipping window. The iterations work on the output buffer and on an internal
+		 one, kept between calls, so that no memory is allocated for signals of the same
+		 length; without smoothing the inner loops are branch-free and vectorized.
+		 @return An error description, or Q_NULLPTR on success.
+		 */
+		const char* background(const double* in, int size, double* out);
+		
+	private:
+		QVector<double> workspace;
 	};
 }
 
@@ -15,9 +15,8 @@ void AA::ComputeProbability::run(){
 		{"LeftExtremum", getLeftExtremum()},
 		{"RightExtremum", getRightExtremum()}
 	});
-	auto evaluator = UMF::EvaluateGaussExp::create();
 	// Build a function that makes the test, given coefficients and histogram
-	auto tester = [this, normalizer, evaluator](QVector<double> X, QVector<double> Y, QVector<double> C)
+	auto tester = [this, normalizer](QVector<double> X, QVector<double> Y, QVector<double> C)
 	{
 		// We assume that the observed array is a histogram with integer values that sum up to the total number of events
 		// Compute the histogram bar step from the input X vector
@@ -40,26 +39,8 @@ void AA::ComputeProbability::run(){
 			normalizer->run();
 			C = normalizer->getOutMoveCoefficients();
 		}
-		// Compute the probability
-		double probability;
-		{
-			// Compute the function integral
-			auto func = [](double x, double xminusa, double bminusx, double &y, void *ptr){
-				auto evaluator = reinterpret_cast<UMF::EvaluateGaussExp*>(ptr);
-				evaluator->setInX({x});
-				evaluator->run();
-				y = evaluator->getOutMoveY().takeFirst();
-			};
-			auto cast_func = static_cast<void (*)(double, double, double, double&, void*)>(func);
-			alglib::autogkstate state;
-			alglib::autogkreport report;
-			alglib::autogksmooth(getLeftExtremum(), centroid, state);
-			// Intra
-			evaluator->setCoefficients(C);
-			alglib::autogkintegrate(state, cast_func, evaluator.data());
-			alglib::autogkresults(state, probability, report);
-		}
-		return probability;
+		// Compute the probability, i.e. the integral of the curve up to the centroid
+		return UMF::CurveNormalization::integral(UMF::CurveNormalization::gaussExp, C, getLeftExtremum(), centroid);
 	};
 	// Test intra and extra
 	auto intra = tester(getInMoveIntraX(), getInMoveIntraY(), getInMoveIntraCoefficients());
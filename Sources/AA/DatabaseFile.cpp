@@ -0,0 +1,360 @@
+#include <AA/DatabaseFile.hpp>
+#include <QDataStream>
+#include <QSaveFile>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+namespace {
+	const char magic[8] = {'C', 'A', 'V', 'A', 'D', 'B', '\r', '\n'};
+	/** Version of the format, to be increased when the format changes. */
+	const quint32 formatVersion = 2;
+	/** Oldest version still read: version 1 has no histograms, its header and curve records end before them. */
+	const quint32 oldestVersion = 1;
+	/** Written in the byte order of the machine, so that a different one is detected. */
+	const quint32 byteOrderMark = 0x01020304;
+	/** Alignment of the sections, a cache line. */
+	const quint64 alignment = 64;
+	/** Both models have four coefficients. */
+	const int maximumCoefficients = 4;
+
+	/** Range of bytes of the file. */
+	struct Section {
+		quint64 Offset;
+		quint64 Size;
+	};
+
+	struct Header {
+		char Magic[8];
+		quint32 Version;
+		quint32 ByteOrder;
+		quint32 HeaderSize;
+		quint32 NumberFiles;
+		quint32 NumberCurves;
+		quint32 Reserved;
+		Section Index;		// NumberFiles+1 offsets (quint64) of the features of each file, in doubles
+		Section Features;	// doubles, three per record
+		Section Summaries;	// six arrays of NumberFiles doubles: count, meanX, meanY, covXX, covXY, covYY
+		Section Groups;		// NumberFiles qint32
+		Section NameIndex;	// NumberFiles+1 offsets (quint64) of the name of each file in Strings
+		Section Curves;		// NumberCurves CurveRecord
+		Section Strings;	// UTF-8 names
+		Section Parameters;	// QVariantMap serialized by QDataStream
+		Section Histograms;	// doubles, the counts of the bins of every curve (since version 2)
+	};
+	static_assert(sizeof(Header) == 176, "The header must have no padding");
+
+	struct CurveRecord {
+		qint32 Model;
+		quint32 Color;
+		qint32 NumberCoefficients;
+		qint32 FirstFile;
+		qint32 NumberFiles;
+		qint32 NumberBins;	// zero in version 1
+		double Minimum;
+		double Maximum;
+		double Coefficients[maximumCoefficients];
+		quint64 NameOffset;
+		quint64 NameSize;
+		double HistogramMinimum;
+		double HistogramMaximum;
+		double BarStep;
+		quint64 CountsOffset;	// in doubles, from the start of Histograms
+	};
+	static_assert(sizeof(CurveRecord) == 120, "The curve record must have no padding");
+
+	/** Size of the header of a version of the format. */
+	quint64 headerSize(quint32 version){
+		return version < 2 ? offsetof(Header, Histograms) : sizeof(Header);
+	}
+
+	/** Size of a curve record of a version of the format. */
+	quint64 curveRecordSize(quint32 version){
+		return version < 2 ? offsetof(CurveRecord, HistogramMinimum) : sizeof(CurveRecord);
+	}
+
+	quint64 aligned(quint64 offset){
+		return (offset + alignment - 1) / alignment * alignment;
+	}
+
+	QByteArray serialize(const QVariantMap& parameters){
+		QByteArray bytes;
+		QDataStream stream(&bytes, QIODevice::WriteOnly);
+		stream.setVersion(QDataStream::Qt_5_6);
+		stream << parameters;
+		return bytes;
+	}
+}
+
+bool AA::DatabaseFile::save(const QString& fileName, const Contents& contents, QString* error){
+	auto fail = [error](const QString& description){
+		if (error) *error = description;
+		return false;
+	};
+	const auto& files = contents.Files;
+	const auto& curves = contents.Curves;
+	const quint64 N = files.size();
+	// Offsets of the features and of the names, and the strings
+	std::vector<quint64> index(N + 1, 0), nameIndex(N + 1, 0);
+	QByteArray strings;
+	for (quint64 k = 0; k < N; ++k){
+		if (files[k].Size < 0 || (files[k].Size > 0 && !files[k].Features))
+			return fail("Missing features of file "+QString::number(k));
+		index[k+1] = index[k] + files[k].Size;
+		strings += files[k].Name.toUtf8();
+		nameIndex[k+1] = strings.size();
+	}
+	std::vector<CurveRecord> records(curves.size());
+	std::vector<double> histograms;
+	for (int c = 0; c < curves.size(); ++c){
+		const auto& curve = curves[c];
+		if (curve.Coefficients.size() > maximumCoefficients)
+			return fail("Curves with more than "+QString::number(maximumCoefficients)+" coefficients are not supported");
+		if (curve.FirstFile < 0 || curve.NumberFiles < 0 || quint64(curve.FirstFile) + curve.NumberFiles > N)
+			return fail("The files of curve "+curve.Name+" are out of range");
+		auto& record = records[c];
+		std::memset(&record, 0, sizeof(CurveRecord));
+		record.Model = curve.Model;
+		record.Color = curve.Color;
+		record.NumberCoefficients = curve.Coefficients.size();
+		record.FirstFile = curve.FirstFile;
+		record.NumberFiles = curve.NumberFiles;
+		record.Minimum = curve.Minimum;
+		record.Maximum = curve.Maximum;
+		std::copy(curve.Coefficients.begin(), curve.Coefficients.end(), record.Coefficients);
+		record.NumberBins = curve.Counts.size();
+		record.HistogramMinimum = curve.HistogramMinimum;
+		record.HistogramMaximum = curve.HistogramMaximum;
+		record.BarStep = curve.BarStep;
+		record.CountsOffset = histograms.size();
+		histograms.insert(histograms.end(), curve.Counts.begin(), curve.Counts.end());
+		const auto name = curve.Name.toUtf8();
+		record.NameOffset = strings.size();
+		record.NameSize = name.size();
+		strings += name;
+	}
+	// Summaries in structure-of-arrays layout, and groups
+	std::vector<double> summaries(6 * N);
+	std::vector<qint32> groups(N);
+	for (quint64 k = 0; k < N; ++k){
+		const auto& S = files[k].Summary;
+		summaries[k] = S.Count;
+		summaries[N + k] = S.MeanX;
+		summaries[2*N + k] = S.MeanY;
+		summaries[3*N + k] = S.CovXX;
+		summaries[4*N + k] = S.CovXY;
+		summaries[5*N + k] = S.CovYY;
+		groups[k] = files[k].Group;
+	}
+	const auto parameters = serialize(contents.Parameters);
+	// Layout of the sections
+	Header header;
+	std::memset(&header, 0, sizeof(Header));
+	std::memcpy(header.Magic, magic, sizeof(magic));
+	header.Version = formatVersion;
+	header.ByteOrder = byteOrderMark;
+	header.HeaderSize = sizeof(Header);
+	header.NumberFiles = N;
+	header.NumberCurves = curves.size();
+	quint64 offset = aligned(sizeof(Header));
+	auto place = [&offset](Section& section, quint64 size){
+		section.Offset = offset;
+		section.Size = size;
+		offset = aligned(offset + size);
+	};
+	place(header.Index, index.size() * sizeof(quint64));
+	place(header.Features, index.back() * sizeof(double));
+	place(header.Summaries, summaries.size() * sizeof(double));
+	place(header.Groups, groups.size() * sizeof(qint32));
+	place(header.NameIndex, nameIndex.size() * sizeof(quint64));
+	place(header.Curves, records.size() * sizeof(CurveRecord));
+	place(header.Histograms, histograms.size() * sizeof(double));
+	place(header.Strings, strings.size());
+	place(header.Parameters, parameters.size());
+	// Write the sections in order, padding each one to its offset; the features are written
+	// straight from the blocks of the files
+	QSaveFile output(fileName);
+	if (!output.open(QFile::WriteOnly)) return fail("Unable to write "+fileName);
+	quint64 position = 0;
+	bool written = true;
+	auto write = [&](const Section& section, const void* data, quint64 size){
+		static const char padding[alignment] = {0};
+		if (position < section.Offset){
+			written = written && output.write(padding, section.Offset - position) == qint64(section.Offset - position);
+			position = section.Offset;
+		}
+		if (size > 0) written = written && output.write(static_cast<const char*>(data), size) == qint64(size);
+		position += size;
+	};
+	write({0, sizeof(Header)}, &header, sizeof(Header));
+	write(header.Index, index.data(), header.Index.Size);
+	for (quint64 k = 0; k < N; ++k){
+		const Section block = {header.Features.Offset + index[k] * sizeof(double), files[k].Size * sizeof(double)};
+		write(block, files[k].Features, block.Size);
+	}
+	write(header.Summaries, summaries.data(), header.Summaries.Size);
+	write(header.Groups, groups.data(), header.Groups.Size);
+	write(header.NameIndex, nameIndex.data(), header.NameIndex.Size);
+	write(header.Curves, records.data(), header.Curves.Size);
+	write(header.Histograms, histograms.data(), header.Histograms.Size);
+	write(header.Strings, strings.constData(), header.Strings.Size);
+	write(header.Parameters, parameters.constData(), header.Parameters.Size);
+	if (!written || !output.commit()) return fail("Unable to write "+fileName);
+	return true;
+}
+
+bool AA::DatabaseFile::fail(const QString& description){
+	error = description;
+	mapped = Q_NULLPTR;
+	file.close();
+	return false;
+}
+
+bool AA::DatabaseFile::isDatabaseFile(const QString& fileName){
+	QFile candidate(fileName);
+	char signature[sizeof(magic)];
+	return candidate.open(QFile::ReadOnly) &&
+	candidate.read(signature, sizeof(magic)) == sizeof(magic) &&
+	std::memcmp(signature, magic, sizeof(magic)) == 0;
+}
+
+bool AA::DatabaseFile::open(const QString& fileName){
+	// Reset the state, the instance can be reused for several files (closing the file also unmaps it)
+	mapped = Q_NULLPTR;
+	file.close();
+	error.clear();
+	file.setFileName(fileName);
+	if (!file.open(QFile::ReadOnly)) return fail("Unable to open "+fileName);
+	const quint64 size = file.size();
+	if (size < headerSize(oldestVersion)) return fail(fileName+" is not a database");
+	mapped = file.map(0, size);
+	if (!mapped) return fail("Unable to map "+fileName);
+	// Check the header, without touching the sections
+	const auto& H = *at<Header>(0);
+	if (std::memcmp(H.Magic, magic, sizeof(magic)) != 0) return fail(fileName+" is not a database");
+	if (H.ByteOrder != byteOrderMark) return fail(fileName+" was written on a machine with a different byte order");
+	if (H.Version < oldestVersion || H.Version > formatVersion)
+		return fail(fileName+" has version "+QString::number(H.Version)+" of the format, versions "+
+					QString::number(oldestVersion)+" to "+QString::number(formatVersion)+" are supported");
+	if (H.HeaderSize != headerSize(H.Version) || size < H.HeaderSize) return fail("Corrupted header in "+fileName);
+	const quint64 N = H.NumberFiles;
+	const Section Header::* sections[] = {&Header::Index, &Header::Features, &Header::Summaries, &Header::Groups,
+		&Header::NameIndex, &Header::Curves, &Header::Strings, &Header::Parameters, &Header::Histograms};
+	for (auto section: sections){
+		// Version 1 has no histograms
+		if (section == &Header::Histograms && H.Version < 2) continue;
+		const auto& S = H.*section;
+		if (S.Offset % alignment != 0 || S.Offset > size || S.Size > size - S.Offset)
+			return fail("Corrupted section in "+fileName);
+	}
+	if (H.Index.Size != (N + 1) * sizeof(quint64) || H.NameIndex.Size != (N + 1) * sizeof(quint64) ||
+		H.Summaries.Size != 6 * N * sizeof(double) || H.Groups.Size != N * sizeof(qint32) ||
+		H.Curves.Size != H.NumberCurves * curveRecordSize(H.Version) ||
+		at<quint64>(H.Index.Offset)[N] * sizeof(double) != H.Features.Size ||
+		at<quint64>(H.NameIndex.Offset)[N] > H.Strings.Size)
+		return fail("Corrupted index in "+fileName);
+	return true;
+}
+
+int AA::DatabaseFile::getNumberFiles() const{
+	return mapped ? int(at<Header>(0)->NumberFiles) : 0;
+}
+
+int AA::DatabaseFile::getNumberCurves() const{
+	return mapped ? int(at<Header>(0)->NumberCurves) : 0;
+}
+
+QString AA::DatabaseFile::string(quint64 offset, quint64 size) const{
+	const auto& strings = at<Header>(0)->Strings;
+	if (offset > strings.Size || size > strings.Size - offset) return QString();
+	return QString::fromUtf8(at<char>(strings.Offset + offset), int(size));
+}
+
+AA::DatabaseFile::Curve AA::DatabaseFile::getCurve(int c) const{
+	Q_ASSERT(c >= 0 && c < getNumberCurves());
+	const auto& H = *at<Header>(0);
+	// Only the fields of the version of the file are read
+	const auto& record = *at<CurveRecord>(H.Curves.Offset + c * curveRecordSize(H.Version));
+	Curve curve;
+	curve.Name = string(record.NameOffset, record.NameSize);
+	curve.Model = record.Model;
+	curve.Color = record.Color;
+	curve.Minimum = record.Minimum;
+	curve.Maximum = record.Maximum;
+	const int numberCoefficients = std::min(std::max(record.NumberCoefficients, 0), maximumCoefficients);
+	curve.Coefficients = QVector<double>(record.Coefficients, record.Coefficients + numberCoefficients);
+	curve.FirstFile = record.FirstFile;
+	curve.NumberFiles = record.NumberFiles;
+	if (H.Version >= 2 && record.NumberBins > 0){
+		// The range is checked here, as the index of the features
+		const quint64 size = H.Histograms.Size / sizeof(double);
+		if (record.CountsOffset > size || quint64(record.NumberBins) > size - record.CountsOffset) return curve;
+		curve.HistogramMinimum = record.HistogramMinimum;
+		curve.HistogramMaximum = record.HistogramMaximum;
+		curve.BarStep = record.BarStep;
+		const auto counts = at<double>(H.Histograms.Offset) + record.CountsOffset;
+		curve.Counts.resize(record.NumberBins);
+		std::copy(counts, counts + record.NumberBins, curve.Counts.begin());
+	}
+	return curve;
+}
+
+const double* AA::DatabaseFile::getFeatures(int k, qint64& size) const{
+	Q_ASSERT(k >= 0 && k < getNumberFiles());
+	const auto& H = *at<Header>(0);
+	const auto index = at<quint64>(H.Index.Offset);
+	// The index is checked here rather than when opening, which would read all of it
+	size = 0;
+	if (index[k] > index[k+1] || index[k+1] > index[H.NumberFiles]) return Q_NULLPTR;
+	size = index[k+1] - index[k];
+	return at<double>(H.Features.Offset) + index[k];
+}
+
+AA::FeaturesSummary AA::DatabaseFile::getSummary(int k) const{
+	Q_ASSERT(k >= 0 && k < getNumberFiles());
+	const auto& H = *at<Header>(0);
+	const quint64 N = H.NumberFiles;
+	const auto S = at<double>(H.Summaries.Offset);
+	FeaturesSummary summary;
+	summary.Count = int(S[k]);
+	summary.MeanX = S[N + k];
+	summary.MeanY = S[2*N + k];
+	summary.CovXX = S[3*N + k];
+	summary.CovXY = S[4*N + k];
+	summary.CovYY = S[5*N + k];
+	return summary;
+}
+
+int AA::DatabaseFile::getGroup(int k) const{
+	Q_ASSERT(k >= 0 && k < getNumberFiles());
+	return at<qint32>(at<Header>(0)->Groups.Offset)[k];
+}
+
+QString AA::DatabaseFile::getName(int k) const{
+	Q_ASSERT(k >= 0 && k < getNumberFiles());
+	const auto index = at<quint64>(at<Header>(0)->NameIndex.Offset);
+	if (index[k] > index[k+1]) return QString();
+	return string(index[k], index[k+1] - index[k]);
+}
+
+QVariantMap AA::DatabaseFile::getParameters() const{
+	QVariantMap parameters;
+	if (!mapped) return parameters;
+	const auto& section = at<Header>(0)->Parameters;
+	// Read in place, the bytes are not copied
+	const auto bytes = QByteArray::fromRawData(at<char>(section.Offset), int(section.Size));
+	QDataStream stream(bytes);
+	stream.setVersion(QDataStream::Qt_5_6);
+	stream >> parameters;
+	return parameters;
+}
+
+AA::DatabaseFile::File AA::DatabaseFile::getFile(int k) const{
+	File entry;
+	entry.Features = getFeatures(k, entry.Size);
+	entry.Summary = getSummary(k);
+	entry.Group = getGroup(k);
+	entry.Name = getName(k);
+	return entry;
+}
@@ -0,0 +1,61 @@
+#include <AA/FeaturesCache.hpp>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace {
+	const quint32 magic = 0x43415646; // "CAVF"
+	/** Version of the entry format, to be increased when the format changes. */
+	const quint32 formatVersion = 2;
+}
+
+AA::FeaturesCache::FeaturesCache(const QString& folder):
+folder(folder){
+	this->folder.mkpath(".");
+}
+
+QString AA::FeaturesCache::defaultFolder(){
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/features";
+}
+
+QString AA::FeaturesCache::entryPath(const QString& file, const QByteArray& parameters) const{
+	QFileInfo info(file);
+	if (!info.exists()) return QString();
+	// Size and modification time identify the content without reading the whole file
+	QByteArray key;
+	QDataStream stream(&key, QIODevice::WriteOnly);
+	stream << formatVersion << info.canonicalFilePath() << info.size()
+	<< info.lastModified().toMSecsSinceEpoch() << parameters;
+	return folder.filePath(QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex() + ".features");
+}
+
+bool AA::FeaturesCache::load(const QString& file, const QByteArray& parameters, Entry& entry) const{
+	QFile cached(entryPath(file, parameters));
+	if (!cached.open(QFile::ReadOnly)) return false;
+	QDataStream stream(&cached);
+	stream.setVersion(QDataStream::Qt_5_6);
+	quint32 fileMagic, fileVersion;
+	stream >> fileMagic >> fileVersion;
+	if (fileMagic != magic || fileVersion != formatVersion) return false;
+	Entry read;
+	stream >> read.SampleRate >> read.TotalRecords >> read.RecordLength >> read.Features >> read.Summary;
+	if (stream.status() != QDataStream::Ok) return false;
+	entry = std::move(read);
+	return true;
+}
+
+bool AA::FeaturesCache::store(const QString& file, const QByteArray& parameters, const Entry& entry) const{
+	const auto path = entryPath(file, parameters);
+	if (path.isEmpty()) return false;
+	// Write to a temporary file renamed on commit, so that readers never see partial entries
+	QSaveFile cached(path);
+	if (!cached.open(QFile::WriteOnly)) return false;
+	QDataStream stream(&cached);
+	stream.setVersion(QDataStream::Qt_5_6);
+	stream << magic << formatVersion;
+	stream << entry.SampleRate << entry.TotalRecords << entry.RecordLength << entry.Features << entry.Summary;
+	return stream.status() == QDataStream::Ok && cached.commit();
+}
@@ -1,12 +1,36 @@
 #include <AA/FeaturesExtractor.hpp>
 
-sf::Mutex AA::FeaturesExtractor::mutex;
+namespace {
+	/** Version of the extraction algorithm, to be increased whenever a change alters the features,
+	 so that the entries cached by previous versions are not used anymore.
+	 */
+	const int featuresVersion = 1;
+
+	/** Number of consecutive records whose spectra are computed together. */
+	const int recordsPerBatch = 16;
+}
 
 void AA::FeaturesExtractor::run(){
-	// Open the audio file
-	sf::InputSoundFile file; {
-		sf::Lock lock(mutex);
-		if (!file.openFromFile(getFile().toStdString())) abort("Unable to open "+getFile());
+	// Look for the features in the cache, unless a single record is inspected
+	QScopedPointer<FeaturesCache> cache;
+	if (getSelectRecord() < 0 && !getCacheFolder().isEmpty()){
+		cache.reset(new FeaturesCache(getCacheFolder()));
+		FeaturesCache::Entry entry;
+		if (cache->load(getFile(), getCacheParameters(), entry)){
+			setOutSampleRate(entry.SampleRate);
+			setOutTotalRecords(entry.TotalRecords);
+			setOutRecordLength(entry.RecordLength);
+			setOutRecordHop(getHopLength() > 0 && getHopLength() < entry.RecordLength ? getHopLength() : entry.RecordLength);
+			setOutFeatures(entry.Features);
+			setOutSummary(entry.Summary);
+			return;
+		}
+	}
+	// Open the audio file (any number of readers can work concurrently)
+	WavReader file;
+	if (!file.open(getFile())){
+		abort(file.getError());
+		return;
 	}
 	// Get audio info
 	const auto sampleCount = file.getSampleCount();
@@ -18,109 +42,195 @@ void AA::FeaturesExtractor::run(){
 		setOutTotalRecords(0);
 		setOutFeatures(QVector<double>());
 		setOutRecordLength(0);
+		setOutSummary(FeaturesSummary());
+		return;
+	}
+	const auto parameters = getPipelineParameters(getOutSampleRate(), file.getChannelCount());
+	const int recordLength = parameters.RecordLength;
+	const int hopLength = parameters.HopLength;
+	setOutRecordLength(recordLength);
+	setOutRecordHop(hopLength);
+	auto numSamplesPerRecord = recordLength*file.getChannelCount();
+	auto numSamplesPerHop = hopLength*file.getChannelCount();
+	// Get the number of records (the last, if incomplete, is discarded by the extraction)
+	const qint64 numFrames = sampleCount / file.getChannelCount();
+	const int numRecords = numFrames < recordLength ? 0 : (numFrames - recordLength) / hopLength + 1;
+	if (hopLength == recordLength)
+		setOutTotalRecords(ceil(double(sampleCount) / double(recordLength)));
+	else
+		setOutTotalRecords(numFrames <= recordLength ? 1 : int(ceil(double(numFrames - recordLength) / double(hopLength))) + 1);
+	if (getSelectRecord() < 0 && hopLength < recordLength && parameters.ChannelsArrangement != UMF::ReduceChannels::interleaved){
+		abort("Overlapping records require interleaved channels");
 		return;
 	}
-	// Given the desired frequency precision (and the sampling frequency), we can compute
-	// the optimal length a record should have. It will be the lowest power of 2 that is bigger
-	// than the one that yields the desired frequency precision: hence the precision is only
-	// used as a minimum.
-	setOutRecordLength(pow(2, ceil(log2(getOutSampleRate()/getMaximumSpectrumLeakage()))));
-	auto numSamplesPerRecord = getOutRecordLength()*file.getChannelCount();
-	// Get the number of records
-	setOutTotalRecords(ceil(double(sampleCount) / double(getOutRecordLength())));
 //	qInfo() << "File" << QFileInfo(getFile()).baseName() << "has" << getOutTotalRecords() << "records with" << getOutRecordLength() << "for" << getOutSampleRate()/getOutRecordLength() << "Hz of spectral leakage";
- 	// Initialization of variables and algorithms
+ 	// Process the whole file in parallel if requested
 	QVector<double> features;
-	features.reserve(3 * getOutTotalRecords());
-	QVector<sf::Int16> samplesData(numSamplesPerRecord);
-	QVector<double> samples(numSamplesPerRecord);
-	auto channelsReduce = UMF::ReduceChannels::create({
-		{"NumberChannels", file.getChannelCount()},
-		{"Operation", getChannelsOperation()},
-		{"ChannelsArrangement", getChannelsArrangement()}
-	});
-	auto windowing = UMF::Windowing::create({
-		{"Length", getOutRecordLength()},
-		{"Type", getWindowingFunction()}
-	});
-	auto gaussianFilter = UMF::GaussianFilter::create({
-		{"Radius", getGaussianFilterWidth()},
-		{"BorderType", getExtrapolationMethod()}
-	});
-	auto spectrumMagnitude = UMF::SpectrumMagnitude::create();
-	auto backgroundRemove = UMF::SpectrumRemoveBackground::create({
-		{"NumberIterations", getBackIterations()},
-		{"Direction", getBackDirection()},
-		{"FilterOrder", getBackFilterOrder()},
-		{"Smoothing", getBackSmoothing()},
-		{"SmoothWindow", getBackSmoothWindow()},
-		{"Compton", getBackCompton()}
-	});
-	// If a record is selected, change loop limits accordingly
-	unsigned int recIdx = 0;
-	unsigned int maxRecIdx = getOutTotalRecords();
-	if (getSelectRecord() >= 0){
-		recIdx = getSelectRecord();
-		maxRecIdx = recIdx + 1;
-		file.seek(recIdx * numSamplesPerRecord);
-	}
-	// Scan each record, or the selected one
-	for (; recIdx < maxRecIdx; recIdx++) {
-		// Read a record from file (the last, if incomplete, will be discarded)
-		// "read"'s maxCount = maxSamplesPerChannel * numberOfChannels
-		if (file.read(samplesData.data(), numSamplesPerRecord) < numSamplesPerRecord) break; // end of file reached
-		// Convert to double
-		std::transform(samplesData.constBegin(), samplesData.constEnd(), samples.begin(), [](const auto& x){return double(x/double(0x7FFF));});
-		// Split the channels and compute their mean. Then apply a windowing function.
-		channelsReduce->setInSignal(samples);
-		channelsReduce->run();
-		// Windowing
-		windowing->getInput(channelsReduce);
-		windowing->run();
-		// Mean filter (former binning)
-		gaussianFilter->getInput(windowing);
-		gaussianFilter->run();
-		Q_EMIT timeSeries(gaussianFilter->getOutSignal());
-		// Compute the signal spectrum (the Fourier Mathematica command divide by sqrt(N))
-		spectrumMagnitude->getInput(gaussianFilter);
-		spectrumMagnitude->run();
-		Q_EMIT frequencySeries(spectrumMagnitude->getOutSignal());
-		// Estimate the background and subtract it from the spectrum
-		backgroundRemove->getInput(spectrumMagnitude);
-		backgroundRemove->run();
-		Q_EMIT frequencySeries(backgroundRemove->getOutSignal());
-		// Split the selected frequency range in three parts and compute the max in each
-		// For each peak, compute the spectral concentration, that is the ratio between
-		// the peak's energy and the total energy on the interval
-		const auto& spectrum = backgroundRemove->getOutSignal();
-		int bin_start = floor(getMinimumFrequency()/getOutSampleRate()*getOutRecordLength());
-		int bin_end = ceil(getMaximumFrequency()/getOutSampleRate()*getOutRecordLength());
-		int bin_step = ceil((bin_end-bin_start+1)/3.0); // both extrema included
-		QVector<int> Formants;
-		QVector<double> spectralConcentration;
-		for(auto left = spectrum.constBegin() + bin_start, right = left + bin_step;
-			left < spectrum.constBegin() + bin_end + 1; left += bin_step, right += bin_step){
-			auto formant = std::distance(spectrum.constBegin(), std::max_element(left, right));
-			Formants << formant;
-			if(auto totalEnergy = std::reduce(left, right); totalEnergy > 0.0)
-				spectralConcentration << sqrt(spectrum[formant] / totalEnergy);
-			else
-				spectralConcentration << 0.0;
+	if (getSelectRecord() < 0 && getNumberThreads() != 1){
+		if (!extractParallel(parameters, numRecords, features)) return;
+	} else if (getSelectRecord() < 0 && hopLength < recordLength) {
+		if (!extractHops(file, parameters, numRecords, features)) return;
+	} else if (getSelectRecord() < 0) {
+		// Process the complete records (the last, if incomplete, is discarded) in batches,
+		// each one a view of the mapped file
+		features.resize(3 * numRecords);
+		RecordPipeline pipeline(parameters);
+		for (int recIdx = 0; recIdx < numRecords; recIdx += recordsPerBatch) {
+			const int count = std::min(recordsPerBatch, numRecords - recIdx);
+			auto samplesData = file.view(qint64(recIdx) * numSamplesPerRecord, qint64(count) * numSamplesPerRecord);
+			if (!samplesData) {
+				abort("Unexpected end of file "+getFile());
+				return;
+			}
+			if (auto error = pipeline.processBatch(samplesData, count, features.data() + 3*recIdx); error){
+				abort(QString(error));
+				return;
+			}
+		}
+	} else {
+		// Inspect the selected record, emitting the intermediate series
+		RecordPipeline pipeline(parameters);
+		auto samplesData = file.view(qint64(getSelectRecord()) * numSamplesPerHop, numSamplesPerRecord);
+		if (samplesData) {
+			features.resize(3);
+			if (auto error = pipeline.process(samplesData, features.data()); error){
+				abort(QString(error));
+				return;
+			}
+			Q_EMIT timeSeries(pipeline.getTimeSeries());
+			Q_EMIT frequencySeries(pipeline.getSpectrum());
+			Q_EMIT frequencySeries(pipeline.getCleanSpectrum());
+			Q_EMIT pointSeries(pipeline.getFormants());
 		}
-		auto meanSpectralConcentration = std::reduce(spectralConcentration.begin(), spectralConcentration.end());
-		meanSpectralConcentration /= double(spectralConcentration.size());
-		Q_EMIT pointSeries(Formants);
-		// Append to the features array
-		auto V1 = double(Formants[1]) / double(Formants[0]);
-		auto V2 = double(Formants[2]) / double(Formants[0]);
-		features << V1 << V2 << meanSpectralConcentration;
 	}
-	features.squeeze();
 	// Normalize weights
 	arma::mat F(features.data(), 3, features.size()/3, false, true);
 	F.row(2) -= F.row(2).min();
 	F.row(2) /= F.row(2).max();
 	F.row(2) %= F.row(2);
+	const auto summary = FeaturesSummary::fromFeatures(features);
+	// Store the features for the next runs
+	if (cache && !cache->store(getFile(), getCacheParameters(), {features, summary, getOutSampleRate(), getOutTotalRecords(), getOutRecordLength()}))
+		qInfo() << "Unable to cache the features of" << getFile() << "in" << getCacheFolder();
 	// Set output
 	setOutFeatures(features);
+	setOutSummary(summary);
+}
+
+AA::RecordPipeline::Parameters AA::FeaturesExtractor::getPipelineParameters(double sampleRate, int numberChannels){
+	RecordPipeline::Parameters P;
+	P.SampleRate = sampleRate;
+	// Given the desired frequency precision (and the sampling frequency), we can compute
+	// the optimal length a record should have. It will be the lowest power of 2 that is bigger
+	// than the one that yields the desired frequency precision: hence the precision is only
+	// used as a minimum.
+	P.RecordLength = pow(2, ceil(log2(sampleRate/getMaximumSpectrumLeakage())));
+	P.HopLength = getHopLength() > 0 && getHopLength() < P.RecordLength ? getHopLength() : P.RecordLength;
+	P.NumberChannels = numberChannels;
+	P.MinimumFrequency = getMinimumFrequency();
+	P.MaximumFrequency = getMaximumFrequency();
+	P.ChannelsOperation = getChannelsOperation();
+	// A single channel is the same in every arrangement
+	P.ChannelsArrangement = numberChannels > 1 ? getChannelsArrangement() : int(UMF::ReduceChannels::interleaved);
+	P.WindowingFunction = getWindowingFunction();
+	P.ExtrapolationMethod = getExtrapolationMethod();
+	P.GaussianFilterWidth = getGaussianFilterWidth();
+	P.BackIterations = getBackIterations();
+	P.BackDirection = getBackDirection();
+	P.BackFilterOrder = getBackFilterOrder();
+	P.BackSmoothing = getBackSmoothing();
+	P.BackSmoothWindow = getBackSmoothWindow();
+	P.BackCompton = getBackCompton();
+	return P;
+}
+
+QByteArray AA::FeaturesExtractor::getCacheParameters(){
+	QByteArray parameters;
+	QDataStream stream(&parameters, QIODevice::WriteOnly);
+	stream.setVersion(QDataStream::Qt_5_6);
+	stream << featuresVersion << getMinimumFrequency() << getMaximumFrequency() << getMaximumSpectrumLeakage()
+	<< getChannelsOperation() << getChannelsArrangement() << getWindowingFunction() << getExtrapolationMethod()
+	<< getGaussianFilterWidth() << getBackIterations() << getBackDirection() << getBackFilterOrder()
+	<< getBackSmoothing() << getBackSmoothWindow() << getBackCompton() << getHopLength();
+	return parameters;
+}
+
+bool AA::FeaturesExtractor::extractParallel(const RecordPipeline::Parameters& parameters, int numRecords, QVector<double>& features){
+	const int numSamplesPerRecord = parameters.RecordLength * parameters.NumberChannels;
+	const int numSamplesPerHop = parameters.HopLength * parameters.NumberChannels;
+	const bool overlapping = numSamplesPerHop < numSamplesPerRecord;
+	features.resize(3 * numRecords);
+	double* output = features.data();
+	// Every worker maps the file and processes the records on its own
+	struct Worker {
+		std::unique_ptr<WavReader> file;
+		std::unique_ptr<RecordPipeline> pipeline;
+	};
+	const int threads = getNumberThreads() < 1 ? QThread::idealThreadCount() : getNumberThreads();
+	std::vector<Worker> workers(threads);
+	QMutex errorMutex;
+	QString error;
+	UMF::parallelFor(0, numRecords, recordsPerBatch, threads, [&](int begin, int end, int w){
+		auto& worker = workers[w];
+		// Lazy initialization, only the workers that actually get some record open the file
+		if (!worker.file){
+			worker.file.reset(new WavReader);
+			if (!worker.file->open(getFile())){
+				QMutexLocker locker(&errorMutex);
+				error = worker.file->getError();
+				return;
+			}
+			worker.pipeline.reset(new RecordPipeline(parameters));
+		}
+		// Chunks are at most recordsPerBatch records long, and are processed as a single batch;
+		// overlapping records of a chunk share a single view, starting the ring buffer at its beginning
+		const qint64 count = end - begin;
+		const qint64 overlap = overlapping ? numSamplesPerRecord - numSamplesPerHop : 0;
+		auto samplesData = worker.file->view(qint64(begin) * numSamplesPerHop, overlap + count * numSamplesPerHop);
+		if (!samplesData){
+			QMutexLocker locker(&errorMutex);
+			error = "Unexpected end of file "+getFile();
+			return;
+		}
+		if (overlapping) worker.pipeline->startHops(samplesData);
+		auto failure = overlapping ?
+			worker.pipeline->processHops(samplesData + overlap, int(count), output + 3*begin) :
+			worker.pipeline->processBatch(samplesData, int(count), output + 3*begin);
+		if (failure){
+			QMutexLocker locker(&errorMutex);
+			error = failure;
+			return;
+		}
+	});
+	if (!error.isEmpty()){
+		abort(error);
+		return false;
+	}
+	return true;
+}
+
+bool AA::FeaturesExtractor::extractHops(WavReader& file, const RecordPipeline::Parameters& parameters, int numRecords, QVector<double>& features){
+	const int numSamplesPerHop = parameters.HopLength * parameters.NumberChannels;
+	const int overlap = parameters.RecordLength * parameters.NumberChannels - numSamplesPerHop;
+	features.resize(3 * numRecords);
+	if (numRecords == 0) return true;
+	RecordPipeline pipeline(parameters);
+	// Fill the ring buffer with the beginning of the first record, then push the hops in batches;
+	// every sample is read, converted and reduced once
+	auto samplesData = file.view(0, overlap);
+	if (samplesData) pipeline.startHops(samplesData);
+	for (int recIdx = 0; samplesData && recIdx < numRecords; recIdx += recordsPerBatch) {
+		const int count = std::min(recordsPerBatch, numRecords - recIdx);
+		samplesData = file.view(overlap + qint64(recIdx) * numSamplesPerHop, qint64(count) * numSamplesPerHop);
+		if (!samplesData) break;
+		if (auto error = pipeline.processHops(samplesData, count, features.data() + 3*recIdx); error){
+			abort(QString(error));
+			return false;
+		}
+	}
+	if (!samplesData) {
+		abort("Unexpected end of file "+getFile());
+		return false;
+	}
+	return true;
 }
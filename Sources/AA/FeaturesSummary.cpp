@@ -0,0 +1,48 @@
+#include <AA/FeaturesSummary.hpp>
+
+AA::FeaturesSummary AA::FeaturesSummary::fromFeatures(const QVector<double>& features){
+	// Same weighted statistics of AA::FeaturesDistance, where the weights are normalized to unit sum
+	FeaturesSummary summary;
+	const int n = features.size() / 3;
+	if (n == 0) return summary;
+	const double* F = features.constData();
+	double norm = 0.0;
+	for (int r = 0; r < n; ++r) norm += std::abs(F[3*r+2]);
+	auto weight = [F, norm](int r){return norm != 0.0 ? F[3*r+2] / norm : F[3*r+2];};
+	double mx = 0.0, my = 0.0;
+	for (int r = 0; r < n; ++r){
+		mx += F[3*r] * weight(r);
+		my += F[3*r+1] * weight(r);
+	}
+	summary.Count = n;
+	summary.MeanX = mx;
+	summary.MeanY = my;
+	if (n > 1){
+		// Accumulate the three distinct elements of the symmetric covariance directly
+		double cxx = 0.0, cxy = 0.0, cyy = 0.0;
+		for (int r = 0; r < n; ++r){
+			const double dx = F[3*r] - mx, dy = F[3*r+1] - my, w = weight(r);
+			cxx += dx * dx * w;
+			cxy += dx * dy * w;
+			cyy += dy * dy * w;
+		}
+		summary.CovXX = cxx;
+		summary.CovXY = cxy;
+		summary.CovYY = cyy;
+	}
+	return summary;
+}
+
+QDataStream& operator<<(QDataStream& stream, const AA::FeaturesSummary& summary){
+	stream << qint32(summary.Count) << summary.MeanX << summary.MeanY
+	<< summary.CovXX << summary.CovXY << summary.CovYY;
+	return stream;
+}
+
+QDataStream& operator>>(QDataStream& stream, AA::FeaturesSummary& summary){
+	qint32 count;
+	stream >> count >> summary.MeanX >> summary.MeanY
+	>> summary.CovXX >> summary.CovXY >> summary.CovYY;
+	summary.Count = count;
+	return stream;
+}
@@ -0,0 +1,92 @@
+#include <AA/MatchingService.hpp>
+#include <QThread>
+#include <UMF/CurveNormalization.hpp>
+#include <UMF/HistogramAccumulator.hpp>
+#include <UMF/ParallelFor.hpp>
+#include <vector>
+
+struct AA::MatchingService::Workspace {
+	UMF::HistogramAccumulator histogram;
+	QVector<SpeakerIndex::Neighbor> neighbors;
+	bool initialized = false;
+};
+
+AA::MatchingService::MatchingService(const QVector<FeaturesSummary>& database,
+									 const QVector<double>& intraCoefficients,
+									 const QVector<double>& extraCoefficients,
+									 const Parameters& parameters):
+parameters(parameters), index(database){
+	// Normalize the curves once, instead of at every test
+	auto normalizer = UMF::CurveNormalization::create({
+		{"LeftExtremum", parameters.LeftExtremum},
+		{"RightExtremum", parameters.RightExtremum}
+	});
+	auto normalize = [&normalizer](const QVector<double>& coefficients){
+		normalizer->setInCoefficients(coefficients);
+		normalizer->run();
+		return normalizer->getOutMoveCoefficients();
+	};
+	intra = normalize(intraCoefficients);
+	extra = normalize(extraCoefficients);
+}
+
+AA::MatchingService::Match AA::MatchingService::match(const FeaturesSummary& unknown) const{
+	Workspace workspace;
+	return match(unknown, workspace);
+}
+
+QVector<AA::MatchingService::Match> AA::MatchingService::match(const QVector<FeaturesSummary>& unknowns) const{
+	QVector<Match> matches(unknowns.size());
+	const int threads = parameters.NumberThreads < 1 ? QThread::idealThreadCount() : parameters.NumberThreads;
+	std::vector<Workspace> workspaces(threads);
+	auto output = matches.data();
+	UMF::parallelFor(0, unknowns.size(), 1, threads, [&](int begin, int end, int w){
+		for (int u = begin; u < end; ++u)
+			output[u] = match(unknowns[u], workspaces[w]);
+	});
+	return matches;
+}
+
+AA::MatchingService::Match AA::MatchingService::match(const FeaturesSummary& unknown, Workspace& workspace) const{
+	const auto& P = parameters;
+	auto& histogram = workspace.histogram;
+	auto& neighbors = workspace.neighbors;
+	// Lazy initialization, the workspace is reused by the following tests of the same thread
+	if (!workspace.initialized){
+		histogram = UMF::HistogramAccumulator(P.MinimumValue, P.MaximumValue, P.BarStep);
+		workspace.initialized = true;
+	}
+	histogram.clear();
+	// Bin the distances from the database files, skipping the ones beyond the histogram range
+	Match result;
+	index.withinRadius(unknown, P.MaximumValue, neighbors);
+	for (const auto& neighbor: neighbors){
+		histogram.add(neighbor.Distance);
+		if (neighbor.Distance < result.ClosestDistance || (neighbor.Distance == result.ClosestDistance && neighbor.Index < result.Closest)){
+			result.ClosestDistance = neighbor.Distance;
+			result.Closest = neighbor.Index;
+		}
+	}
+	// The closest file may be farther than the histogram range
+	if (result.Closest < 0){
+		const auto closest = index.nearest(unknown, 1);
+		if (!closest.isEmpty()){
+			result.Closest = closest.first().Index;
+			result.ClosestDistance = closest.first().Distance;
+		}
+	}
+	// Centroid of the histogram, as computed by AA::ComputeProbability
+	double sum = 0.0, count = 0.0;
+	const auto& bins = histogram.getBins();
+	for (std::size_t k = 0; k < bins.size(); ++k){
+		sum += (P.MinimumValue + P.BarStep * (k + 0.5)) * bins[k];
+		count += bins[k];
+	}
+	if (count == 0.0) return result;
+	result.Centroid = sum / count;
+	// Probability of the intra-speaker and extra-speaker curves up to the centroid
+	const double probabilityIntra = UMF::CurveNormalization::integral(UMF::CurveNormalization::gaussExp, intra, P.LeftExtremum, result.Centroid);
+	const double probabilityExtra = UMF::CurveNormalization::integral(UMF::CurveNormalization::gaussExp, extra, P.LeftExtremum, result.Centroid);
+	result.Score = (probabilityIntra + probabilityExtra) / 2.0;
+	return result;
+}
@@ -0,0 +1,145 @@
+#include <AA/PairwiseDistances.hpp>
+
+namespace {
+	/** Number of files processed as a block of rows, i.e. the grain of the parallel loop. */
+	const int rowBlock = 16;
+	/** Number of files processed as a block of columns, sized to keep their statistics in L1. */
+	const int columnBlock = 256;
+	/** Maximum conditioning number, as in AA::FeaturesDistance. */
+	const double maxCond = 0.1;
+}
+
+void AA::PairwiseDistances::Statistics::resize(int size){
+	for (auto array: {&count, &meanX, &meanY, &covXX, &covXY, &covYY})
+		array->resize(size);
+}
+
+void AA::PairwiseDistances::Statistics::set(int k, const AA::FeaturesSummary& summary){
+	count[k] = summary.Count;
+	meanX[k] = summary.MeanX;
+	meanY[k] = summary.MeanY;
+	covXX[k] = summary.CovXX;
+	covXY[k] = summary.CovXY;
+	covYY[k] = summary.CovYY;
+}
+
+AA::FeaturesSummary AA::PairwiseDistances::Statistics::get(int k) const{
+	AA::FeaturesSummary summary;
+	summary.Count = int(count[k]);
+	summary.MeanX = meanX[k];
+	summary.MeanY = meanY[k];
+	summary.CovXX = covXX[k];
+	summary.CovXY = covXY[k];
+	summary.CovYY = covYY[k];
+	return summary;
+}
+
+void AA::PairwiseDistances::distances(const AA::FeaturesSummary& summary, const Statistics& S, int begin, int end, double* out){
+	const double nA = summary.Count, mxA = summary.MeanX, myA = summary.MeanY;
+	const SymmetricMatrix2 A = {summary.CovXX, summary.CovXY, summary.CovYY};
+	const double* __restrict nB = S.count.constData();
+	const double* __restrict mxB = S.meanX.constData();
+	const double* __restrict myB = S.meanY.constData();
+	const double* __restrict aB = S.covXX.constData();
+	const double* __restrict bB = S.covXY.constData();
+	const double* __restrict cB = S.covYY.constData();
+	// Branch-free body, so that the compiler can process several pairs per instruction
+	for (int j = begin; j < end; ++j){
+		// Average covariance of the two files, replaced by the identity if ill-conditioned
+		const auto C = SymmetricMatrix2::pooled(nA, A, nB[j], {aB[j], bB[j], cB[j]}).regularized(maxCond);
+		// Squared Mahalanobis distance between the weighted means
+		out[j - begin] = C.inverseQuadraticForm(mxA - mxB[j], myA - myB[j]);
+	}
+}
+
+void AA::PairwiseDistances::run(){
+	const auto& summaries = getInSummaries();
+	const auto& groups = getInGroups();
+	if (summaries.size() != groups.size()){
+		abort("Summaries ("+QString::number(summaries.size())+") and groups ("+QString::number(groups.size())+") must have the same size");
+		return;
+	}
+	const double step = getBarStep(), minimum = getMinimumValue(), maximum = getMaximumValue();
+	if (!(step > 0.0) || maximum < minimum){
+		abort("Invalid histogram range");
+		return;
+	}
+	const int numberFiles = summaries.size();
+	const int enrolled = std::min(std::max(getNumberEnrolled(), 0), numberFiles);
+	const int threads = getNumberThreads() < 1 ? QThread::idealThreadCount() : getNumberThreads();
+	// Sort the enrolled files and the new ones by group, so that every new file is paired with at most two
+	// contiguous ranges of the files before it: those of its group, enrolled and new, or those of the other groups
+	QVector<int> order(numberFiles);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.begin() + enrolled, [&groups](int i, int j){return groups[i] < groups[j];});
+	std::stable_sort(order.begin() + enrolled, order.end(), [&groups](int i, int j){return groups[i] < groups[j];});
+	QVector<int> sorted(numberFiles);
+	for (int k = 0; k < numberFiles; ++k) sorted[k] = groups[order[k]];
+	QVector<int> first(numberFiles), last(numberFiles), second(numberFiles), secondLast(numberFiles);
+	for (int i = enrolled; i < numberFiles; ++i){
+		const auto enrolledGroup = std::equal_range(sorted.constBegin(), sorted.constBegin() + enrolled, sorted[i]);
+		const int enrolledBegin = enrolledGroup.first - sorted.constBegin(), enrolledEnd = enrolledGroup.second - sorted.constBegin();
+		const int groupBegin = std::lower_bound(sorted.constBegin() + enrolled, sorted.constBegin() + i, sorted[i]) - sorted.constBegin();
+		switch (getPairs()) {
+			case intra:
+				first[i] = enrolledBegin; last[i] = enrolledEnd;
+				second[i] = groupBegin; secondLast[i] = i;
+				break;
+			case extra:
+				first[i] = 0; last[i] = enrolledBegin;
+				second[i] = enrolledEnd; secondLast[i] = groupBegin;
+				break;
+			default:
+				first[i] = 0; last[i] = i;
+				second[i] = secondLast[i] = i;
+				break;
+		}
+	}
+	// Arrange the statistics of the files in the same order
+	Statistics S;
+	S.resize(numberFiles);
+	for (int k = 0; k < numberFiles; ++k) S.set(k, summaries[order[k]]);
+	// Compute the distances tile by tile, counting them in the shard of each thread
+	UMF::ConcurrentHistogram histogram(minimum, maximum, step, threads);
+	std::vector<std::vector<double>> buffers(threads);
+	UMF::parallelFor(enrolled, numberFiles, rowBlock, threads, [&](int begin, int end, int w){
+		auto& buffer = buffers[w];
+		auto& shard = histogram.shard(w);
+		if (buffer.empty()) buffer.resize(columnBlock);
+		int columnsBegin = numberFiles, columnsEnd = 0;
+		for (int i = begin; i < end; ++i){
+			for (const auto& range: {std::make_pair(first[i], last[i]), std::make_pair(second[i], secondLast[i])}){
+				if (range.first >= range.second) continue;
+				columnsBegin = std::min(columnsBegin, range.first);
+				columnsEnd = std::max(columnsEnd, range.second);
+			}
+		}
+		for (int J = columnsBegin; J < columnsEnd; J += columnBlock){
+			for (int i = begin; i < end; ++i){
+				for (const auto& range: {std::make_pair(first[i], last[i]), std::make_pair(second[i], secondLast[i])}){
+					const int left = std::max(range.first, J), right = std::min(range.second, J + columnBlock);
+					if (left >= right) continue;
+					distances(S.get(i), S, left, right, buffer.data());
+					for (int k = 0; k < right - left; ++k)
+						buffer[k] = std::sqrt(buffer[k]);
+					shard.add(buffer.data(), right - left);
+				}
+			}
+		}
+	});
+	// Merge the shards
+	auto merged = histogram.merged();
+	setOutNumberDistances(merged.getTotal());
+	// Add the distances of the enrolled files
+	const auto& enrolledCounts = getInEnrolledCounts();
+	if (!enrolledCounts.isEmpty() && !merged.addCounts(enrolledCounts)){
+		abort("Enrolled counts ("+QString::number(enrolledCounts.size())+") do not match the bins ("+QString::number(merged.getNumberBins())+")");
+		return;
+	}
+	QVector<double> X, Y;
+	merged.getHistogram(X, Y, getSuppressZeroCount());
+	setOutCounts(merged.getCounts());
+	setOutHistX(X);
+	setOutHistY(Y);
+	Q_EMIT histogramReady(X, Y);
+}
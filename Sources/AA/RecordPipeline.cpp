@@ -0,0 +1,160 @@
+#include <AA/RecordPipeline.hpp>
+
+AA::RecordPipeline::RecordPipeline(const Parameters& parameters):
+parameters(parameters){
+	const auto& P = parameters;
+	// Create the processing stages
+	channelsReduce = UMF::ReduceChannels::create({
+		{"NumberChannels", P.NumberChannels},
+		{"Operation", P.ChannelsOperation},
+		{"ChannelsArrangement", P.ChannelsArrangement}
+	});
+	windowing = UMF::Windowing::create({
+		{"Length", P.RecordLength},
+		{"Type", P.WindowingFunction}
+	});
+	gaussianFilter = UMF::GaussianFilter::create({
+		{"Radius", P.GaussianFilterWidth},
+		{"BorderType", P.ExtrapolationMethod}
+	});
+	spectrumMagnitude = UMF::SpectrumMagnitude::create();
+	backgroundRemove = UMF::SpectrumRemoveBackground::create({
+		{"NumberIterations", P.BackIterations},
+		{"Direction", P.BackDirection},
+		{"FilterOrder", P.BackFilterOrder},
+		{"Smoothing", P.BackSmoothing},
+		{"SmoothWindow", P.BackSmoothWindow},
+		{"Compton", P.BackCompton}
+	});
+	// Allocate the intermediate buffers
+	samples.resize(P.RecordLength * P.NumberChannels);
+	reduced.resize(P.RecordLength);
+	filtered.resize(P.RecordLength);
+	spectrum.resize(P.RecordLength/2+1);
+	cleanSpectrum.resize(P.RecordLength/2+1);
+	if (P.HopLength > 0 && P.HopLength < P.RecordLength)
+		ring.resize(P.RecordLength);
+	ringHead = 0;
+	// Split the selected frequency range in three parts
+	binStart = floor(P.MinimumFrequency/P.SampleRate*P.RecordLength);
+	binEnd = ceil(P.MaximumFrequency/P.SampleRate*P.RecordLength);
+	binStep = ceil((binEnd-binStart+1)/3.0); // both extrema included
+	std::fill_n(formants, 3, 0);
+	numberFormants = 0;
+}
+
+const char* AA::RecordPipeline::process(const qint16* input, double* features){
+	// Convert to double
+	convert(input, samples.size(), samples.data());
+	// Split the channels and compute their mean. Then apply a windowing function.
+	channelsReduce->apply(samples.constData(), samples.size(), reduced.data());
+	windowing->apply(reduced.data());
+	// Mean filter (former binning)
+	gaussianFilter->apply(reduced.constData(), reduced.size(), filtered.data());
+	// Compute the signal spectrum
+	spectrumMagnitude->apply(filtered.constData(), filtered.size(), spectrum.data());
+	return computeFeatures(spectrum.constData(), features);
+}
+
+const char* AA::RecordPipeline::processBatch(const qint16* input, int count, double* features){
+	const int recordLength = parameters.RecordLength;
+	reserveBatch(count);
+	// Time domain stages, record by record
+	for (int r = 0; r < count; ++r){
+		convert(input + qint64(r) * samples.size(), samples.size(), samples.data());
+		channelsReduce->apply(samples.constData(), samples.size(), reduced.data());
+		windowing->apply(reduced.data());
+		gaussianFilter->apply(reduced.constData(), reduced.size(), batchFiltered.data() + qint64(r) * recordLength);
+	}
+	return batchFeatures(count, features);
+}
+
+void AA::RecordPipeline::startHops(const qint16* input){
+	ringHead = 0;
+	push(input, parameters.RecordLength - parameters.HopLength);
+}
+
+const char* AA::RecordPipeline::processHops(const qint16* input, int count, double* features){
+	const int recordLength = parameters.RecordLength;
+	const int hopLength = parameters.HopLength;
+	const int hopSamples = hopLength * parameters.NumberChannels;
+	reserveBatch(count);
+	for (int r = 0; r < count; ++r){
+		// Only the new samples are converted and reduced
+		push(input + qint64(r) * hopSamples, hopLength);
+		// Unroll the ring buffer, oldest sample first, then apply the time domain stages
+		std::copy(ring.constBegin() + ringHead, ring.constEnd(), reduced.begin());
+		std::copy(ring.constBegin(), ring.constBegin() + ringHead, reduced.begin() + (recordLength - ringHead));
+		windowing->apply(reduced.data());
+		gaussianFilter->apply(reduced.constData(), reduced.size(), batchFiltered.data() + qint64(r) * recordLength);
+	}
+	return batchFeatures(count, features);
+}
+
+void AA::RecordPipeline::push(const qint16* input, int length){
+	const int recordLength = parameters.RecordLength;
+	const int numberChannels = parameters.NumberChannels;
+	convert(input, length * numberChannels, samples.data());
+	// Interleaved channels can be reduced in two parts, before and after the end of the ring
+	const int tail = std::min(length, recordLength - ringHead);
+	channelsReduce->apply(samples.constData(), tail * numberChannels, ring.data() + ringHead);
+	channelsReduce->apply(samples.constData() + tail * numberChannels, (length - tail) * numberChannels, ring.data());
+	ringHead = (ringHead + length) % recordLength;
+}
+
+void AA::RecordPipeline::reserveBatch(int count){
+	const int recordLength = parameters.RecordLength;
+	if (batchFiltered.size() < count * recordLength){
+		batchFiltered.resize(count * recordLength);
+		batchSpectra.resize(count * (recordLength/2+1));
+	}
+}
+
+const char* AA::RecordPipeline::batchFeatures(int count, double* features){
+	const int recordLength = parameters.RecordLength;
+	const int spectrumLength = recordLength/2+1;
+	// Spectra of all the records at once
+	spectrumMagnitude->applyBatch(batchFiltered.constData(), recordLength, count, batchSpectra.data());
+	for (int r = 0; r < count; ++r){
+		if (auto error = computeFeatures(batchSpectra.constData() + qint64(r) * spectrumLength, features + 3*r); error)
+			return error;
+	}
+	return Q_NULLPTR;
+}
+
+const char* AA::RecordPipeline::computeFeatures(const double* spectrum, double* features){
+	// Estimate the background and subtract it from the spectrum
+	if (auto error = backgroundRemove->apply(spectrum, cleanSpectrum.size(), cleanSpectrum.data()); error)
+		return error;
+	// For each of the three parts of the frequency range compute the max and the spectral
+	// concentration, that is the ratio between the peak's energy and the total energy on the interval
+	const auto begin = cleanSpectrum.constData();
+	double spectralConcentration = 0.0;
+	std::fill_n(formants, 3, 0);
+	numberFormants = 0;
+	for(auto left = begin + binStart, right = left + binStep;
+		left < begin + binEnd + 1 && numberFormants < 3; left += binStep, right += binStep){
+		auto formant = std::distance(begin, std::max_element(left, right));
+		formants[numberFormants++] = formant;
+		if(auto totalEnergy = std::reduce(left, right); totalEnergy > 0.0)
+			spectralConcentration += sqrt(begin[formant] / totalEnergy);
+	}
+	// Features of the record
+	features[0] = double(formants[1]) / double(formants[0]);
+	features[1] = double(formants[2]) / double(formants[0]);
+	features[2] = spectralConcentration / double(numberFormants);
+	return Q_NULLPTR;
+}
+
+void AA::RecordPipeline::convert(const qint16* __restrict in, int size, double* __restrict out){
+	// Plain indexed loop on non-aliasing pointers, so that the compiler can widen, convert and divide
+	// several samples per instruction; the division is kept to give exactly the same values as before.
+	for (int k = 0; k < size; ++k)
+		out[k] = double(in[k]) / double(0x7FFF);
+}
+
+QVector<int> AA::RecordPipeline::getFormants() const{
+	QVector<int> Formants(numberFormants);
+	std::copy(formants, formants+numberFormants, Formants.begin());
+	return Formants;
+}
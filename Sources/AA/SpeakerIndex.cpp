@@ -0,0 +1,232 @@
+#include <AA/SpeakerIndex.hpp>
+#include <algorithm>
+#include <cmath>
+#include <queue>
+
+namespace {
+	/** Number of files of a leaf, whose distances are computed together. */
+	const int leafSize = 32;
+	/** Relative margin of the bounds, larger than the rounding errors of the distances. */
+	const double boundMargin = 1.0 - 1e-9;
+	/** Minimum reciprocal condition number of the pooled covariance, as in AA::FeaturesDistance. */
+	const double maxCond = 0.1;
+
+	/** Largest eigenvalue of the symmetric matrix [a b; b c]. */
+	double largestEigenvalue(double a, double b, double c){
+		return 0.5 * (a + c) + std::hypot(0.5 * (a - c), b);
+	}
+
+	double smallestEigenvalue(double a, double b, double c){
+		return 0.5 * (a + c) - std::hypot(0.5 * (a - c), b);
+	}
+
+	/** Whether the bound of the distances holds for a file: it has records and a positive semidefinite covariance. */
+	bool isRegular(const AA::FeaturesSummary& S){
+		return S.Count > 0 && std::isfinite(S.MeanX) && std::isfinite(S.MeanY) &&
+		std::isfinite(S.CovXX) && std::isfinite(S.CovXY) && std::isfinite(S.CovYY) &&
+		S.CovXX >= 0.0 && S.CovYY >= 0.0 && S.CovXX * S.CovYY - S.CovXY * S.CovXY >= 0.0;
+	}
+}
+
+AA::SpeakerIndex::SpeakerIndex(const QVector<FeaturesSummary>& summaries){
+	const int N = summaries.size();
+	// Average covariance of the files, weighted by their records as in the pooled covariance
+	double count = 0.0, a = 0.0, b = 0.0, c = 0.0;
+	std::vector<int> files, outliers;
+	for (int k = 0; k < N; ++k){
+		const auto& S = summaries[k];
+		if (!isRegular(S)){
+			outliers.push_back(k);
+			continue;
+		}
+		files.push_back(k);
+		count += S.Count;
+		a += S.Count * S.CovXX;
+		b += S.Count * S.CovXY;
+		c += S.Count * S.CovYY;
+	}
+	// Whitening by the inverse of its Cholesky factor, unless it is singular
+	if (count > 0.0 && a * c - b * b > 0.0){
+		a /= count; b /= count; c /= count;
+		const double l11 = std::sqrt(a);
+		const double l21 = b / l11;
+		const double l22 = std::sqrt(c - l21 * l21);
+		w11 = 1.0 / l11;
+		w21 = - l21 / (l11 * l22);
+		w22 = 1.0 / l22;
+	}
+	identitySpread = largestEigenvalue(w11 * w11, w11 * w21, w21 * w21 + w22 * w22);
+	numberIndexed = files.size();
+	if (numberIndexed > 0){
+		std::vector<Query> points(N);
+		for (int k: files) points[k] = whiten(summaries[k]);
+		nodes.reserve(2 * numberIndexed / leafSize + 2);
+		build(files, 0, numberIndexed, points);
+	}
+	// Statistics in the order of the leaves, followed by the files out of the tree
+	files.insert(files.end(), outliers.begin(), outliers.end());
+	statistics.resize(N);
+	order.resize(N);
+	for (int k = 0; k < N; ++k){
+		statistics.set(k, summaries[files[k]]);
+		order[k] = files[k];
+	}
+}
+
+int AA::SpeakerIndex::build(std::vector<int>& files, int begin, int end, const std::vector<Query>& points){
+	Node node;
+	node.Lower[0] = node.Lower[1] = node.Smallest = std::numeric_limits<double>::infinity();
+	node.Upper[0] = node.Upper[1] = - std::numeric_limits<double>::infinity();
+	node.Spread = node.Largest = 0.0;
+	node.Begin = begin;
+	node.End = end;
+	node.Left = node.Right = -1;
+	for (int i = begin; i < end; ++i){
+		const auto& point = points[files[i]];
+		node.Lower[0] = std::min(node.Lower[0], point.X);
+		node.Upper[0] = std::max(node.Upper[0], point.X);
+		node.Lower[1] = std::min(node.Lower[1], point.Y);
+		node.Upper[1] = std::max(node.Upper[1], point.Y);
+		node.Spread = std::max(node.Spread, point.Spread);
+		node.Smallest = std::min(node.Smallest, point.Smallest);
+		node.Largest = std::max(node.Largest, point.Largest);
+	}
+	const int index = nodes.size();
+	nodes.push_back(node);
+	if (end - begin <= leafSize) return index;
+	// Split the widest side at the median
+	const bool alongX = node.Upper[0] - node.Lower[0] >= node.Upper[1] - node.Lower[1];
+	const int middle = begin + (end - begin) / 2;
+	std::nth_element(files.begin() + begin, files.begin() + middle, files.begin() + end, [&points, alongX](int i, int j){
+		return alongX ? points[i].X < points[j].X : points[i].Y < points[j].Y;
+	});
+	const int left = build(files, begin, middle, points);
+	const int right = build(files, middle, end, points);
+	nodes[index].Left = left;
+	nodes[index].Right = right;
+	return index;
+}
+
+AA::SpeakerIndex::Query AA::SpeakerIndex::whiten(const FeaturesSummary& summary) const{
+	Query query;
+	query.X = w11 * summary.MeanX;
+	query.Y = w21 * summary.MeanX + w22 * summary.MeanY;
+	const double m11 = w11 * w11 * summary.CovXX;
+	const double m12 = w11 * (w21 * summary.CovXX + w22 * summary.CovXY);
+	const double m22 = w21 * w21 * summary.CovXX + 2.0 * w21 * w22 * summary.CovXY + w22 * w22 * summary.CovYY;
+	query.Spread = largestEigenvalue(m11, m12, m22);
+	query.Smallest = smallestEigenvalue(summary.CovXX, summary.CovXY, summary.CovYY);
+	query.Largest = largestEigenvalue(summary.CovXX, summary.CovXY, summary.CovYY);
+	query.Regular = isRegular(summary);
+	return query;
+}
+
+double AA::SpeakerIndex::bound(const Query& query, const Node& node) const{
+	// Nothing can be skipped when the bound does not hold for the query
+	if (!query.Regular) return 0.0;
+	const double dx = std::max({node.Lower[0] - query.X, 0.0, query.X - node.Upper[0]});
+	const double dy = std::max({node.Lower[1] - query.Y, 0.0, query.Y - node.Upper[1]});
+	double spread = std::max(query.Spread, node.Spread);
+	// The eigenvalues of the pooled covariance lie between the ones of the two files, and its
+	// reciprocal condition number in norm 1 is at least half their ratio: if that is not enough,
+	// the pooled covariance may be replaced by the identity
+	const double smallest = std::min(query.Smallest, node.Smallest);
+	const double largest = std::max(query.Largest, node.Largest);
+	if (!(smallest >= 2.0 * maxCond * largest * (1.0 + 1e-6))) spread = std::max(spread, identitySpread);
+	return (dx * dx + dy * dy) / spread * boundMargin;
+}
+
+template <typename Visitor>
+void AA::SpeakerIndex::scan(const FeaturesSummary& query, int begin, int end, Visitor&& visit) const{
+	double distances[leafSize];
+	for (int first = begin; first < end; first += leafSize){
+		const int last = std::min(first + leafSize, end);
+		PairwiseDistances::distances(query, statistics, first, last, distances);
+		for (int j = first; j < last; ++j)
+			visit(order[j], std::sqrt(distances[j - first]));
+	}
+}
+
+QVector<AA::SpeakerIndex::Neighbor> AA::SpeakerIndex::nearest(const FeaturesSummary& query, int k) const{
+	QVector<Neighbor> result;
+	if (k <= 0 || size() == 0) return result;
+	// Max-heap of the k closest files found
+	auto closer = [](const Neighbor& a, const Neighbor& b){
+		return a.Distance < b.Distance || (a.Distance == b.Distance && a.Index < b.Index);
+	};
+	std::vector<Neighbor> best;
+	best.reserve(k);
+	auto visit = [&](int index, double distance){
+		if (std::isnan(distance)) return;
+		const Neighbor neighbor = {index, distance};
+		if (int(best.size()) < k){
+			best.push_back(neighbor);
+			std::push_heap(best.begin(), best.end(), closer);
+		}else if (closer(neighbor, best.front())){
+			std::pop_heap(best.begin(), best.end(), closer);
+			best.back() = neighbor;
+			std::push_heap(best.begin(), best.end(), closer);
+		}
+	};
+	// Squared distance which a node must beat to contain one of the k closest files
+	auto threshold = [&](){
+		return int(best.size()) < k ? std::numeric_limits<double>::infinity() : best.front().Distance * best.front().Distance;
+	};
+	scan(query, numberIndexed, size(), visit);
+	if (!nodes.empty()){
+		// Best-first traversal, visiting the nodes by increasing bound
+		const auto q = whiten(query);
+		typedef std::pair<double, int> Entry;
+		std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+		queue.push({bound(q, nodes[0]), 0});
+		while (!queue.empty()){
+			const auto [lower, n] = queue.top();
+			queue.pop();
+			if (lower > threshold()) break;
+			const auto& node = nodes[n];
+			if (node.Left < 0){
+				scan(query, node.Begin, node.End, visit);
+				continue;
+			}
+			for (int child: {node.Left, node.Right}){
+				const double childBound = bound(q, nodes[child]);
+				if (childBound <= threshold()) queue.push({childBound, child});
+			}
+		}
+	}
+	std::sort(best.begin(), best.end(), closer);
+	result.reserve(best.size());
+	for (const auto& neighbor: best) result << neighbor;
+	return result;
+}
+
+int AA::SpeakerIndex::withinRadius(const FeaturesSummary& query, double radius, QVector<Neighbor>& neighbors) const{
+	neighbors.clear();
+	int farther = 0;
+	auto visit = [&](int index, double distance){
+		if (distance <= radius) neighbors << Neighbor{index, distance};
+		else if (distance > radius) ++farther;
+	};
+	scan(query, numberIndexed, size(), visit);
+	if (nodes.empty()) return farther;
+	// Depth-first traversal, skipping the nodes farther than the radius
+	const auto q = whiten(query);
+	const double threshold = radius >= 0.0 ? radius * radius : -1.0;
+	int stack[64];
+	int top = 0;
+	stack[top++] = 0;
+	while (top > 0){
+		const auto& node = nodes[stack[--top]];
+		if (bound(q, node) > threshold){
+			farther += node.End - node.Begin;
+			continue;
+		}
+		if (node.Left < 0){
+			scan(query, node.Begin, node.End, visit);
+			continue;
+		}
+		stack[top++] = node.Right;
+		stack[top++] = node.Left;
+	}
+	return farther;
+}
@@ -0,0 +1,127 @@
+#include <AA/StreamingExtractor.hpp>
+
+namespace {
+	/** Maximum number of records whose spectra are computed together. */
+	const int recordsPerBatch = 16;
+}
+
+AA::StreamingExtractor::StreamingExtractor(const RecordPipeline::Parameters& parameters):
+parameters(parameters),
+pipeline(parameters){
+	const auto& P = parameters;
+	hopLength = P.HopLength > 0 && P.HopLength < P.RecordLength ? P.HopLength : P.RecordLength;
+	// The pending buffer holds either the beginning of the first record or a hop
+	pending.resize(std::max(P.RecordLength - hopLength, hopLength) * P.NumberChannels);
+	reset();
+}
+
+void AA::StreamingExtractor::reset(){
+	pendingSize = 0;
+	started = false;
+	records = 0;
+	std::fill_n(origin, 3, 0.0);
+	minimumWeight = maximumWeight = 0.0;
+	std::fill_n(&moments[0][0], 3*6, 0.0);
+}
+
+const char* AA::StreamingExtractor::push(const qint16* samples, qint64 count, QVector<double>& features){
+	const qint64 hopSamples = qint64(hopLength) * parameters.NumberChannels;
+	auto collect = [&](qint64 size){
+		const qint64 taken = std::min(count, size - pendingSize);
+		std::copy(samples, samples + taken, pending.begin() + pendingSize);
+		pendingSize += taken;
+		samples += taken;
+		count -= taken;
+		return pendingSize == size;
+	};
+	if (!started){
+		// Collect the samples the first record shares with its (missing) predecessor
+		const qint64 overlap = qint64(parameters.RecordLength - hopLength) * parameters.NumberChannels;
+		if (!collect(overlap)) return Q_NULLPTR;
+		if (overlap > 0) pipeline.startHops(pending.constData());
+		pendingSize = 0;
+		started = true;
+	}
+	// Complete the pending hop
+	if (pendingSize > 0){
+		if (!collect(hopSamples)) return Q_NULLPTR;
+		pendingSize = 0;
+		if (auto error = process(pending.constData(), 1, features); error)
+			return error;
+	}
+	// Process the whole hops straight from the chunk, in batches
+	while (count >= hopSamples){
+		const int hops = int(std::min<qint64>(count / hopSamples, recordsPerBatch));
+		if (auto error = process(samples, hops, features); error)
+			return error;
+		samples += hops * hopSamples;
+		count -= hops * hopSamples;
+	}
+	// Keep the rest for the next chunk
+	collect(hopSamples);
+	return Q_NULLPTR;
+}
+
+const char* AA::StreamingExtractor::process(const qint16* samples, int count, QVector<double>& features){
+	const int first = features.size();
+	features.resize(first + 3*count);
+	double* output = features.data() + first;
+	const auto error = hopLength < parameters.RecordLength ?
+		pipeline.processHops(samples, count, output) :
+		pipeline.processBatch(samples, count, output);
+	if (error){
+		features.resize(first);
+		return error;
+	}
+	for (int r = 0; r < count; ++r)
+		accumulate(output + 3*r);
+	return Q_NULLPTR;
+}
+
+void AA::StreamingExtractor::accumulate(const double* features){
+	// Moments are taken relative to the first record, to limit the cancellation when the weights are shifted
+	if (records == 0){
+		std::copy(features, features+3, origin);
+		minimumWeight = maximumWeight = features[2];
+	}
+	minimumWeight = std::min(minimumWeight, features[2]);
+	maximumWeight = std::max(maximumWeight, features[2]);
+	const double x = features[0] - origin[0], y = features[1] - origin[1], d = features[2] - origin[2];
+	const double monomials[6] = {1.0, x, y, x*x, x*y, y*y};
+	const double powers[3] = {1.0, d, d*d};
+	for (int k = 0; k < 3; ++k)
+		for (int j = 0; j < 6; ++j)
+			moments[k][j] += powers[k] * monomials[j];
+	++records;
+}
+
+AA::FeaturesSummary AA::StreamingExtractor::getSummary() const{
+	FeaturesSummary summary;
+	if (records == 0) return summary;
+	// AA::FeaturesExtractor divides by the range of the weights, giving NaN weights when there is none
+	if (!(maximumWeight > minimumWeight)){
+		summary.Count = records;
+		if (records > 1)
+			summary.CovXX = summary.CovXY = summary.CovYY = std::numeric_limits<double>::quiet_NaN();
+		return summary;
+	}
+	// AA::FeaturesExtractor weights each record by ((w-min)/(max-min))^2, normalized to unit sum:
+	// the scale cancels out, and the sums weighted by (w-min)^2 = (d-s)^2 follow from the moments
+	const double s = minimumWeight - origin[2];
+	double sums[6];
+	for (int j = 0; j < 6; ++j)
+		sums[j] = moments[2][j] - 2.0 * s * moments[1][j] + s * s * moments[0][j];
+	summary.Count = records;
+	const double norm = sums[0];
+	// Null weights are used as they are, as AA::FeaturesSummary::fromFeatures does
+	const double mx = norm != 0.0 ? sums[1] / norm : 0.0;
+	const double my = norm != 0.0 ? sums[2] / norm : 0.0;
+	summary.MeanX = norm != 0.0 ? origin[0] + mx : 0.0;
+	summary.MeanY = norm != 0.0 ? origin[1] + my : 0.0;
+	if (records > 1){
+		summary.CovXX = norm != 0.0 ? sums[3] / norm - mx * mx : 0.0;
+		summary.CovXY = norm != 0.0 ? sums[4] / norm - mx * my : 0.0;
+		summary.CovYY = norm != 0.0 ? sums[5] / norm - my * my : 0.0;
+	}
+	return summary;
+}
@@ -0,0 +1,153 @@
+#include <AA/WavReader.hpp>
+#include <QtEndian>
+#include <cstring>
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+	const quint16 formatPCM = 0x0001;
+	const quint16 formatExtensible = 0xFFFE;
+}
+
+bool AA::WavReader::fail(const QString& description){
+	error = description;
+	mapped = Q_NULLPTR;
+	file.close();
+	return false;
+}
+
+bool AA::WavReader::open(const QString& fileName){
+	// Reset the state, the instance can be reused for several files (closing the file also unmaps it)
+	mapped = Q_NULLPTR;
+	file.close();
+	error.clear();
+	sampleRate = channelCount = bytesPerSample = 0;
+	sampleCount = dataOffset = position = 0;
+	file.setFileName(fileName);
+	if (!file.open(QFile::ReadOnly)) return fail("Unable to open "+fileName);
+	// Check the RIFF header
+	uchar header[12];
+	if (file.read(reinterpret_cast<char*>(header), 12) != 12 ||
+		memcmp(header, "RIFF", 4) != 0 || memcmp(header+8, "WAVE", 4) != 0)
+		return fail(fileName+" is not a RIFF/WAVE file");
+	// Scan the chunks looking for the format and the data
+	bool formatFound = false;
+	while (true) {
+		uchar chunk[8];
+		if (file.read(reinterpret_cast<char*>(chunk), 8) != 8)
+			return fail("No data found in "+fileName);
+		const qint64 chunkSize = qFromLittleEndian<quint32>(chunk+4);
+		const qint64 chunkStart = file.pos();
+		if (memcmp(chunk, "fmt ", 4) == 0) {
+			uchar format[40] = {0};
+			if (chunkSize < 16 || file.read(reinterpret_cast<char*>(format), std::min<qint64>(chunkSize, 40)) < 16)
+				return fail("Corrupted format chunk in "+fileName);
+			quint16 formatTag = qFromLittleEndian<quint16>(format);
+			channelCount = qFromLittleEndian<quint16>(format+2);
+			sampleRate = qFromLittleEndian<quint32>(format+4);
+			bytesPerSample = qFromLittleEndian<quint16>(format+14) / 8;
+			// The extensible format stores the actual format in the first two bytes of the sub-format GUID
+			if (formatTag == formatExtensible && chunkSize >= 40)
+				formatTag = qFromLittleEndian<quint16>(format+24);
+			if (formatTag != formatPCM)
+				return fail("Only PCM samples are supported, "+fileName+" uses format "+QString::number(formatTag));
+			if (channelCount == 0 || sampleRate == 0 || bytesPerSample < 1 || bytesPerSample > 4)
+				return fail("Unsupported sample format in "+fileName);
+			formatFound = true;
+		} else if (memcmp(chunk, "data", 4) == 0) {
+			if (!formatFound) return fail("Data chunk precedes the format chunk in "+fileName);
+			// Some writers do not fill in the data size, so it is limited to the actual file size
+			const qint64 dataSize = std::min(chunkSize, file.size() - chunkStart);
+			const qint64 frameSize = bytesPerSample * channelCount;
+			dataOffset = chunkStart;
+			sampleCount = (dataSize / frameSize) * channelCount;
+			// Map the samples; when it fails (e.g. special files) the samples are read on demand
+			if (sampleCount > 0) mapped = file.map(dataOffset, sampleCount * bytesPerSample);
+#ifdef Q_OS_UNIX
+			// Records are mostly consumed in order, let the kernel read ahead aggressively
+			if (mapped) {
+				const auto page = quintptr(sysconf(_SC_PAGESIZE));
+				const auto start = quintptr(mapped) & ~(page - 1);
+				posix_madvise(reinterpret_cast<void*>(start), quintptr(mapped) - start + sampleCount * bytesPerSample, POSIX_MADV_SEQUENTIAL);
+			}
+#endif
+			return true;
+		}
+		// Chunks are aligned to two bytes
+		if (!file.seek(chunkStart + chunkSize + (chunkSize & 1)))
+			return fail("No data found in "+fileName);
+	}
+}
+
+void AA::WavReader::seek(qint64 sampleOffset){
+	position = std::min(std::max(sampleOffset, qint64(0)), sampleCount);
+	if (!mapped) file.seek(dataOffset + position * bytesPerSample);
+}
+
+const qint16* AA::WavReader::view(qint64 sampleOffset, qint64 count){
+	if (!file.isOpen() || sampleOffset < 0 || count < 0 || sampleOffset + count > sampleCount) return Q_NULLPTR;
+	if (mapped) {
+		const uchar* raw = mapped + sampleOffset * bytesPerSample;
+		// Native samples are handed out in place
+		if (bytesPerSample == 2 && Q_BYTE_ORDER == Q_LITTLE_ENDIAN && quintptr(raw) % alignof(qint16) == 0)
+			return reinterpret_cast<const qint16*>(raw);
+		if (scratch.size() < count) scratch.resize(count);
+		decode(raw, count, scratch.data());
+		return scratch.constData();
+	}
+	// Read the samples, preserving the current position
+	if (scratch.size() < count) scratch.resize(count);
+	const qint64 current = position;
+	seek(sampleOffset);
+	const qint64 read = this->read(scratch.data(), count);
+	seek(current);
+	return read < count ? Q_NULLPTR : scratch.constData();
+}
+
+qint64 AA::WavReader::read(qint16* samples, qint64 maxCount){
+	if (!file.isOpen()) return 0;
+	const qint64 count = std::min(maxCount, sampleCount - position);
+	if (count <= 0) return 0;
+	qint64 bytes;
+	if (mapped) {
+		const uchar* raw = mapped + position * bytesPerSample;
+		if (bytesPerSample == 2 && Q_BYTE_ORDER == Q_LITTLE_ENDIAN)
+			memcpy(samples, raw, count * 2);
+		else
+			decode(raw, count, samples);
+		bytes = count * bytesPerSample;
+	} else if (bytesPerSample == 2 && Q_BYTE_ORDER == Q_LITTLE_ENDIAN) {
+		// Native format, read straight into the output buffer
+		bytes = file.read(reinterpret_cast<char*>(samples), count * 2);
+	} else {
+		if (buffer.size() < count * bytesPerSample) buffer.resize(count * bytesPerSample);
+		bytes = file.read(buffer.data(), count * bytesPerSample);
+		if (bytes > 0) decode(reinterpret_cast<const uchar*>(buffer.constData()), bytes / bytesPerSample, samples);
+	}
+	if (bytes <= 0) return 0;
+	position += bytes / bytesPerSample;
+	return bytes / bytesPerSample;
+}
+
+void AA::WavReader::decode(const uchar* raw, qint64 count, qint16* samples) const{
+	switch (bytesPerSample) {
+		case 1: // unsigned
+			for (qint64 k = 0; k < count; ++k)
+				samples[k] = qint16((qint16(raw[k]) - 128) << 8);
+			break;
+		case 2:
+			for (qint64 k = 0; k < count; ++k)
+				samples[k] = qFromLittleEndian<qint16>(raw + 2*k);
+			break;
+		case 3: // keep the most significant bytes
+			for (qint64 k = 0; k < count; ++k)
+				samples[k] = qint16(raw[3*k+1] | (raw[3*k+2] << 8));
+			break;
+		case 4:
+			for (qint64 k = 0; k < count; ++k)
+				samples[k] = qint16(qFromLittleEndian<qint32>(raw + 4*k) >> 16);
+			break;
+	}
+}
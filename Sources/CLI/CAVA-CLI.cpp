@@ -0,0 +1,621 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QSettings>
+#include <QTextStream>
+#include <QThread>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+#include <AA/ComputeProbability.hpp>
+#include <AA/DatabaseFile.hpp>
+#include <AA/FeaturesDistance.hpp>
+#include <AA/FeaturesExtractor.hpp>
+#include <AA/MatchingService.hpp>
+#include <AA/PairwiseDistances.hpp>
+#include <AA/SpeakerIndex.hpp>
+#include <AA/StreamingExtractor.hpp>
+#include <AA/WavReader.hpp>
+#include <UMF/CurveNormalization.hpp>
+#include <UMF/HistogramAccumulator.hpp>
+#include <UMF/Evaluate1D.hpp>
+#include <UMF/ParallelFor.hpp>
+#include <GUI/ScanDirectory.hpp>
+
+namespace {
+
+	/** Result of the features extraction on a single file. */
+	struct Extraction {
+		QString file;
+		int group; /**< Index of the directory containing the file (one per speaker) */
+		QVector<double> features;
+		AA::FeaturesSummary summary;
+		int records = 0;
+		double seconds = 0.0;
+	};
+
+	QTextStream& out(){
+		static QTextStream stream(stdout);
+		return stream;
+	}
+
+	QTextStream& err(){
+		static QTextStream stream(stderr);
+		return stream;
+	}
+
+	/** Read the parameters stored by the GUI in the given settings group. */
+	QAlgorithm::PropertyMap getPropsInGroup(const QString& group){
+		QSettings settings;
+		settings.beginGroup(group);
+		QAlgorithm::PropertyMap parameters;
+		for(auto& key: settings.childKeys())
+			parameters.insert(key, settings.value(key));
+		settings.endGroup();
+		return parameters;
+	}
+
+	/** Run body(k) for every k in [0, count) using the given number of threads. */
+	template <typename Function>
+	void parallelFor(int count, int threads, Function&& body){
+		UMF::parallelFor(0, count, 1, threads, [&body](int begin, int end, int){
+			for(int k = begin; k < end; ++k) body(k);
+		});
+	}
+
+	/** Scan a folder and extract the features of every audio file found.
+	 Timing and throughput are printed for each file as soon as it is processed.
+	 @param[in] skip Absolute paths of the files not to extract, e.g. those already in a database.
+	 */
+	QVector<Extraction> extractFolder(const QString& folder, int threads, int recordThreads, const QString& cacheFolder,
+									  const QSet<QString>& skip = QSet<QString>()){
+		// Scan the directory as the GUI does, one sublist per subdirectory
+		auto dirScanner = GUI::ScanDirectory::create({
+			{"Extensions", QStringList({"*.wav"})},
+			{"Folder", folder},
+			{"Recursive", true}
+		});
+		dirScanner->run();
+		QVector<Extraction> extractions;
+		int group = 0;
+		for(const auto& dir: dirScanner->getOutContent()){
+			for(const auto& file: dir){
+				if(skip.contains(QFileInfo(file).absoluteFilePath())) continue;
+				Extraction extraction;
+				extraction.file = file;
+				extraction.group = group;
+				extractions << extraction;
+			}
+			++group;
+		}
+		// Set up features extraction parameters
+		QAlgorithm::PropertyMap FEPars = {
+			{"File", QString()},
+			{"SelectRecord", -1}
+		};
+		FEPars.unite(getPropsInGroup("FeaturesExtraction"));
+		FEPars.insert("NumberThreads", recordThreads);
+		FEPars.insert("CacheFolder", cacheFolder);
+		// Extract the features of each file
+		QMutex printMutex;
+		QElapsedTimer totalTimer;
+		totalTimer.start();
+		auto extraction_ptr = extractions.data();
+		parallelFor(extractions.size(), threads, [&](int k){
+			auto& extraction = extraction_ptr[k];
+			auto parameters = FEPars;
+			parameters["File"] = extraction.file;
+			auto extractor = AA::FeaturesExtractor::create(parameters);
+			QElapsedTimer timer;
+			timer.start();
+			extractor->run();
+			extraction.seconds = timer.nsecsElapsed() * 1e-9;
+			extraction.features = extractor->getOutFeatures();
+			extraction.summary = extractor->getOutSummary();
+			extraction.records = extraction.features.size() / 3;
+			QMutexLocker lock(&printMutex);
+			out() << extraction.file << "\t" << extraction.records << " records\t"
+			<< extraction.seconds * 1e3 << " ms\t"
+			<< (extraction.seconds > 0.0 ? extraction.records / extraction.seconds : 0.0) << " records/s" << endl;
+		});
+		// Print the overall throughput
+		double seconds = totalTimer.nsecsElapsed() * 1e-9;
+		int records = std::accumulate(extractions.begin(), extractions.end(), 0,
+									  [](int sum, const Extraction& e){return sum + e.records;});
+		out() << "Extracted " << extractions.size() << " files (" << records << " records) in "
+		<< seconds << " s: " << extractions.size() / seconds << " files/s, "
+		<< records / seconds << " records/s" << endl;
+		// Files without any complete record cannot be compared
+		for(auto it = extractions.begin(); it != extractions.end();){
+			if(it->features.isEmpty()){
+				err() << "Skipping " << it->file << ": no features extracted" << endl;
+				it = extractions.erase(it);
+			}else ++it;
+		}
+		return extractions;
+	}
+
+	/** Fit a Gauss-Exp curve to the histogram and return its normalized coefficients. */
+	QVector<double> fitHistogram(const QVector<double>& X,
+								 const QVector<double>& Y){
+		auto fitting = UMF::FittingGaussExp::create(getPropsInGroup("Fitting"));
+		QVector<double> coefficients;
+		QObject::connect(fitting.data(), &UMF::Fitting1D::fittingReady,
+						 [&coefficients](QVector<double> C){ coefficients = C; });
+		fitting->setInX(X);
+		fitting->setInY(Y);
+		fitting->run();
+		return coefficients;
+	}
+
+	QString toString(const QVector<double>& vector){
+		QStringList list;
+		for(const auto& x: vector) list << QString::number(x);
+		return "[" + list.join(", ") + "]";
+	}
+
+	/** Curve fitted to the histogram with bins X, with the counts of the bins of the given histogram algorithm
+	 so that files can be enrolled later.
+	 */
+	AA::DatabaseFile::Curve makeCurve(const QString& name, const AA::PairwiseDistances& histogram,
+									  const QVector<double>& X, const QVector<double>& coefficients, int numberFiles){
+		AA::DatabaseFile::Curve curve;
+		curve.Name = name;
+		curve.Model = UMF::CurveNormalization::gaussExp;
+		curve.Minimum = X.first();
+		curve.Maximum = X.last();
+		curve.Coefficients = coefficients;
+		curve.NumberFiles = numberFiles;
+		curve.HistogramMinimum = histogram.getMinimumValue();
+		curve.HistogramMaximum = histogram.getMaximumValue();
+		curve.BarStep = histogram.getBarStep();
+		curve.Counts = histogram.getOutCounts();
+		return curve;
+	}
+
+	/** Save the features of the database and the curves fitted to its histograms, with the settings. */
+	bool saveDatabase(const QString& fileName, const QVector<Extraction>& database,
+					  const QVector<AA::DatabaseFile::Curve>& curves, QString& error){
+		AA::DatabaseFile::Contents contents;
+		for(const auto& extraction: database){
+			AA::DatabaseFile::File file;
+			file.Features = extraction.features.constData();
+			file.Size = extraction.features.size();
+			file.Summary = extraction.summary;
+			file.Group = extraction.group;
+			file.Name = extraction.file;
+			contents.Files << file;
+		}
+		contents.Curves = curves;
+		QSettings settings;
+		for(const auto& key: settings.allKeys())
+			contents.Parameters.insert(key, settings.value(key));
+		return AA::DatabaseFile::save(fileName, contents, &error);
+	}
+
+	/** Load a database file, whose first two curves are the intra-speaker and the extra-speaker ones.
+	 Only the summaries of the files of the first curve are read, the features stay in the file.
+	 */
+	bool loadDatabase(const QString& fileName, QVector<Extraction>& database,
+					  QVector<double>& intraCoefficients, QVector<double>& extraCoefficients){
+		AA::DatabaseFile file;
+		if(!file.open(fileName)){
+			err() << file.getError() << endl;
+			return false;
+		}
+		if(file.getNumberCurves() < 2){
+			err() << fileName << " has no intra-speaker and extra-speaker curves" << endl;
+			return false;
+		}
+		const auto intra = file.getCurve(0);
+		intraCoefficients = intra.Coefficients;
+		extraCoefficients = file.getCurve(1).Coefficients;
+		for(int k = intra.FirstFile; k < intra.FirstFile + intra.NumberFiles; ++k){
+			Extraction extraction;
+			extraction.file = file.getName(k);
+			extraction.group = file.getGroup(k);
+			extraction.summary = file.getSummary(k);
+			extraction.records = extraction.summary.Count;
+			database << extraction;
+		}
+		// The unknown voices are extracted with the current settings, which should be the ones of the database
+		const auto parameters = file.getParameters();
+		const auto current = getPropsInGroup("FeaturesExtraction");
+		for(auto i = current.constBegin(); i != current.constEnd(); ++i){
+			const auto key = "FeaturesExtraction/" + i.key();
+			if(parameters.contains(key) && parameters.value(key) != i.value()){
+				err() << "Warning: the database was created with " << key << " = " << parameters.value(key).toString()
+				<< ", the current value is " << i.value().toString() << endl;
+			}
+		}
+		return true;
+	}
+
+	/** Add the files of a folder, with one subdirectory per speaker, to a database file saved with its histograms.
+	 Only the distances of the pairs with a new file are computed: they are added to the stored histograms, then
+	 the curves are fitted again, so that the cost grows with the files added rather than with the database.
+	 Speakers are matched by the name of their subdirectory, the files of new speakers form new groups.
+	 The features of the database are read in place and written to the output with the new ones, together with
+	 the first two curves; the output can be the database file itself, which is replaced.
+	 */
+	bool enroll(const QString& fileName, const QString& folder, const QString& output,
+				int threads, int recordThreads, const QString& cacheFolder){
+		AA::DatabaseFile file;
+		if(!file.open(fileName)){
+			err() << file.getError() << endl;
+			return false;
+		}
+		if(file.getNumberCurves() < 2){
+			err() << fileName << " has no intra-speaker and extra-speaker curves" << endl;
+			return false;
+		}
+		QVector<AA::DatabaseFile::Curve> curves = {file.getCurve(0), file.getCurve(1)};
+		for(const auto& curve: curves){
+			if(curve.Counts.isEmpty()){
+				err() << fileName << " has no histogram of the curve " << curve.Name << ", it must be created again from its folder" << endl;
+				return false;
+			}
+			if(curve.FirstFile != curves[0].FirstFile || curve.NumberFiles != curves[0].NumberFiles){
+				err() << "The curves of " << fileName << " were fitted to different files" << endl;
+				return false;
+			}
+		}
+		if(file.getNumberCurves() > 2)
+			err() << "Warning: only the first two curves of " << fileName << " are kept" << endl;
+		// Files of the database, read in place, and their speakers
+		QVector<AA::DatabaseFile::File> files;
+		QSet<QString> enrolledFiles;
+		QHash<QString, int> speakers;
+		int numberGroups = 0;
+		for(int k = curves[0].FirstFile; k < curves[0].FirstFile + curves[0].NumberFiles; ++k){
+			const auto entry = file.getFile(k);
+			if(!entry.Features){
+				err() << "Corrupted index in " << fileName << endl;
+				return false;
+			}
+			enrolledFiles.insert(QFileInfo(entry.Name).absoluteFilePath());
+			speakers.insert(QFileInfo(entry.Name).absoluteDir().dirName(), entry.Group);
+			numberGroups = std::max(numberGroups, entry.Group + 1);
+			files << entry;
+		}
+		const int enrolled = files.size();
+		// The files already in the database are not extracted again
+		auto added = extractFolder(folder, threads, recordThreads, cacheFolder, enrolledFiles);
+		if(added.isEmpty()){
+			err() << "No new audio files in " << folder << endl;
+			return false;
+		}
+		for(auto& extraction: added){
+			const auto speaker = QFileInfo(extraction.file).absoluteDir().dirName();
+			if(!speakers.contains(speaker)) speakers.insert(speaker, numberGroups++);
+			extraction.group = speakers.value(speaker);
+			AA::DatabaseFile::File entry;
+			entry.Features = extraction.features.constData();
+			entry.Size = extraction.features.size();
+			entry.Summary = extraction.summary;
+			entry.Group = extraction.group;
+			entry.Name = extraction.file;
+			files << entry;
+		}
+		QVector<AA::FeaturesSummary> summaries;
+		QVector<int> groups;
+		for(const auto& entry: files){
+			summaries << entry.Summary;
+			groups << entry.Group;
+		}
+		// Distances of the new files, added to the stored histograms with the same bins
+		QElapsedTimer timer;
+		timer.start();
+		qint64 count = 0;
+		for(int c = 0; c < curves.size(); ++c){
+			auto& curve = curves[c];
+			auto HistPars = getPropsInGroup("Histogram");
+			HistPars.insert("MinimumValue", curve.HistogramMinimum);
+			HistPars.insert("MaximumValue", curve.HistogramMaximum);
+			HistPars.insert("BarStep", curve.BarStep);
+			HistPars.insert("NumberThreads", threads);
+			HistPars.insert("NumberEnrolled", enrolled);
+			auto histCompute = AA::PairwiseDistances::create(HistPars);
+			histCompute->setPairs(c == 0 ? AA::PairwiseDistances::intra : AA::PairwiseDistances::extra);
+			histCompute->setInSummaries(summaries);
+			histCompute->setInGroups(groups);
+			histCompute->setInEnrolledCounts(curve.Counts);
+			histCompute->run();
+			const auto X = histCompute->getOutHistX();
+			if(histCompute->getOutCounts().size() != curve.Counts.size() || X.isEmpty()){
+				err() << "The histogram of the curve " << curve.Name << " does not match its bins" << endl;
+				return false;
+			}
+			count += histCompute->getOutNumberDistances();
+			// The name and the color of the curve are kept
+			curve.Model = UMF::CurveNormalization::gaussExp;
+			curve.Minimum = X.first();
+			curve.Maximum = X.last();
+			curve.Coefficients = fitHistogram(X, histCompute->getOutHistY());
+			curve.FirstFile = 0;
+			curve.NumberFiles = files.size();
+			curve.Counts = histCompute->getOutCounts();
+		}
+		const double seconds = timer.nsecsElapsed() * 1e-9;
+		out() << "Computed " << count << " distances of " << added.size() << " new files in " << seconds << " s: "
+		<< count / seconds << " distances/s" << endl;
+		AA::DatabaseFile::Contents contents;
+		contents.Files = files;
+		contents.Curves = curves;
+		contents.Parameters = file.getParameters();
+		QString error;
+		if(!AA::DatabaseFile::save(output, contents, &error)){
+			err() << error << endl;
+			return false;
+		}
+		out() << "Enrolled " << added.size() << " files in " << output << ", " << files.size() << " files in total" << endl;
+		return true;
+	}
+
+	/** Extract the features of a live source, printing for every record the closest speaker of the database.
+	 The source is either a WAV file, replayed at real-time rate, or raw 16 bit PCM read from the
+	 standard input ("-"), with the given sample rate and number of channels. Samples are pushed in
+	 chunks of 20 ms, and the distances from the database files are updated after every record.
+	 */
+	int stream(const QString& source, double sampleRate, int numberChannels, const QVector<Extraction>& database){
+		AA::WavReader file;
+		const bool replay = source != "-";
+		if (replay){
+			if (!file.open(source)){
+				err() << file.getError() << endl;
+				return 1;
+			}
+			sampleRate = file.getSampleRate();
+			numberChannels = file.getChannelCount();
+		}
+		auto extractor = AA::FeaturesExtractor::create(getPropsInGroup("FeaturesExtraction"));
+		if (extractor->getMaximumFrequency() > sampleRate/2){
+			err() << "Maximum frequency required exceeds Nyquist frequency" << endl;
+			return 1;
+		}
+		const auto parameters = extractor->getPipelineParameters(sampleRate, numberChannels);
+		AA::StreamingExtractor streaming(parameters);
+		out() << "Streaming records of " << parameters.RecordLength << " samples every "
+		<< streaming.getHopLength() << " samples from " << (replay ? source : QString("the standard input")) << endl;
+		// Speakers are named after the directories of their files
+		int numberSpeakers = 0;
+		for (const auto& extraction: database)
+			numberSpeakers = std::max(numberSpeakers, extraction.group + 1);
+		QVector<QString> speakers(numberSpeakers);
+		for (const auto& extraction: database)
+			speakers[extraction.group] = QFileInfo(extraction.file).absoluteDir().dirName();
+		QVector<AA::FeaturesSummary> summaries;
+		summaries.reserve(database.size());
+		for (const auto& extraction: database)
+			summaries << extraction.summary;
+		const AA::SpeakerIndex index(summaries);
+		const int chunkSize = std::max(1, int(sampleRate / 50)) * numberChannels;
+		QVector<qint16> chunk(chunkSize);
+		QVector<double> features;
+		QElapsedTimer clock;
+		clock.start();
+		qint64 pushed = 0;
+		while (true){
+			const qint64 count = replay ? file.read(chunk.data(), chunkSize) : qint64(fread(chunk.data(), sizeof(qint16), chunkSize, stdin));
+			if (count <= 0) break;
+			features.clear();
+			if (auto error = streaming.push(chunk.constData(), count, features); error){
+				err() << error << endl;
+				return 1;
+			}
+			pushed += count;
+			if (!features.isEmpty()){
+				// Closest speaker, the one of the closest file, once the weights of the records have a range
+				const auto summary = streaming.getSummary();
+				const auto closest = std::isnan(summary.MeanX) ? QVector<AA::SpeakerIndex::Neighbor>() : index.nearest(summary, 1);
+				for (int r = 0; r < features.size()/3; ++r){
+					out() << "Record " << streaming.getRecords() - features.size()/3 + r << "\t"
+					<< pushed / numberChannels / sampleRate << " s\t" << toString(features.mid(3*r, 3));
+					if (r == features.size()/3 - 1 && !closest.isEmpty())
+						out() << "\t" << speakers.at(database.at(closest.first().Index).group) << "\t" << closest.first().Distance;
+					out() << endl;
+				}
+			}
+			// Keep the pace of the recording when replaying a file
+			if (replay){
+				const qint64 due = qint64(1e3 * pushed / numberChannels / sampleRate);
+				if (due > clock.elapsed()) QThread::msleep(due - clock.elapsed());
+			}
+		}
+		out() << "Streamed " << pushed / numberChannels / sampleRate << " s in " << clock.nsecsElapsed() * 1e-9 << " s, "
+		<< streaming.getRecords() << " records" << endl;
+		return 0;
+	}
+}
+
+int main(int argc, char* argv[]){
+	QCoreApplication::setApplicationName("CAVA");
+	QCoreApplication::setOrganizationName("DMind");
+	QCoreApplication app(argc, argv);
+	// Parse the command line
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Headless database creation and matching.\n"
+									 "Parameters are read from the settings stored by the graphical interface.");
+	parser.addHelpOption();
+	parser.addPositionalArgument("database", "Database folder, with one subdirectory per speaker, or database file saved by --output or by the graphical interface.");
+	parser.addPositionalArgument("unknown", "Optional folder with the unknown voices to be matched.", "[unknown]");
+	QCommandLineOption threadsOption({"t", "threads"}, "Number of worker threads.", "n",
+									 QString::number(QThread::idealThreadCount()));
+	parser.addOption(threadsOption);
+	QCommandLineOption recordThreadsOption({"r", "record-threads"},
+										   "Number of threads extracting the records of each file, useful for long files.", "n", "1");
+	parser.addOption(recordThreadsOption);
+	QCommandLineOption cacheOption({"c", "cache"}, "Folder of the features cache.", "folder",
+								   AA::FeaturesCache::defaultFolder());
+	parser.addOption(cacheOption);
+	QCommandLineOption noCacheOption("no-cache", "Always extract the features, without reading or writing the cache.");
+	parser.addOption(noCacheOption);
+	QCommandLineOption streamOption({"s", "stream"}, "Score a live source against the database speakers, record by record: "
+									"a WAV file replayed at real-time rate, or raw 16 bit PCM from the standard input with -.", "source");
+	parser.addOption(streamOption);
+	QCommandLineOption rateOption("rate", "Sample rate of the PCM read from the standard input.", "Hz", "44100");
+	parser.addOption(rateOption);
+	QCommandLineOption channelsOption("channels", "Number of interleaved channels of the PCM read from the standard input.", "n", "1");
+	parser.addOption(channelsOption);
+	QCommandLineOption eachOption({"e", "each"}, "Score every unknown voice on its own, rather than the whole unknown folder as a single voice.");
+	parser.addOption(eachOption);
+	QCommandLineOption outputOption({"o", "output"}, "Save the database to a file, which can replace the database folder in the following runs.", "file");
+	parser.addOption(outputOption);
+	QCommandLineOption enrollOption("enroll", "Add the new files of a folder, with one subdirectory per speaker, to the database file, "
+									"computing only their distances; the database is saved to --output, or replaced.", "folder");
+	parser.addOption(enrollOption);
+	parser.process(app);
+	const auto arguments = parser.positionalArguments();
+	if(arguments.isEmpty() || arguments.size() > 2) parser.showHelp(1);
+	const int threads = std::max(1, parser.value(threadsOption).toInt());
+	const int recordThreads = parser.value(recordThreadsOption).toInt();
+	const QString cacheFolder = parser.isSet(noCacheOption) ? QString() : parser.value(cacheOption);
+	// Extract the features of the database, or load a database saved by --output, after enrolling new files
+	const bool saved = QFileInfo(arguments.at(0)).isFile();
+	QString databasePath = arguments.at(0);
+	if(parser.isSet(enrollOption)){
+		if(!saved){
+			err() << "Files can only be enrolled into a database file" << endl;
+			return 1;
+		}
+		if(parser.isSet(outputOption)) databasePath = parser.value(outputOption);
+		if(!enroll(arguments.at(0), parser.value(enrollOption), databasePath, threads, recordThreads, cacheFolder)) return 1;
+	}
+	QVector<Extraction> database;
+	QVector<double> intraCoefficients, extraCoefficients;
+	QElapsedTimer timer;
+	timer.start();
+	if(saved){
+		if(!loadDatabase(databasePath, database, intraCoefficients, extraCoefficients)) return 1;
+		out() << "Loaded " << database.size() << " files from " << databasePath << " in "
+		<< timer.nsecsElapsed() * 1e-6 << " ms" << endl;
+	}else{
+		database = extractFolder(databasePath, threads, recordThreads, cacheFolder);
+	}
+	if(database.isEmpty()){
+		err() << "No audio files in " << databasePath << endl;
+		return 1;
+	}
+	if(parser.isSet(streamOption))
+		return stream(parser.value(streamOption), parser.value(rateOption).toDouble(),
+					  std::max(1, parser.value(channelsOption).toInt()), database);
+	QVector<AA::FeaturesSummary> summaries;
+	QVector<int> groups;
+	for(const auto& extraction: database){
+		summaries << extraction.summary;
+		groups << extraction.group;
+	}
+	if(!saved){
+		// Compute the histograms of the intra-speaker and extra-speaker distances, each unordered pair once
+		timer.restart();
+		auto HistPars = getPropsInGroup("Histogram");
+		HistPars.insert("NumberThreads", threads);
+		auto computeDistribution = [&](AA::PairwiseDistances::pairs pairs){
+			auto histCompute = AA::PairwiseDistances::create(HistPars);
+			histCompute->setPairs(pairs);
+			histCompute->setInSummaries(summaries);
+			histCompute->setInGroups(groups);
+			histCompute->run();
+			return histCompute;
+		};
+		const auto intraHistogram = computeDistribution(AA::PairwiseDistances::intra);
+		const auto extraHistogram = computeDistribution(AA::PairwiseDistances::extra);
+		const auto intraX = intraHistogram->getOutHistX(), extraX = extraHistogram->getOutHistX();
+		const auto intraCount = intraHistogram->getOutNumberDistances();
+		const auto extraCount = extraHistogram->getOutNumberDistances();
+		const double seconds = timer.nsecsElapsed() * 1e-9;
+		out() << "Computed " << intraCount + extraCount << " distances in " << seconds << " s: "
+		<< (intraCount + extraCount) / seconds << " distances/s" << endl;
+		if(intraCount == 0 || extraCount == 0){
+			err() << "At least two speakers, one of which with two files, are required" << endl;
+			return 1;
+		}
+		// Fit the intra/extra distributions
+		intraCoefficients = fitHistogram(intraX, intraHistogram->getOutHistY());
+		extraCoefficients = fitHistogram(extraX, extraHistogram->getOutHistY());
+		if(parser.isSet(outputOption)){
+			const QVector<AA::DatabaseFile::Curve> curves = {
+				makeCurve("Intra-Speaker", *intraHistogram, intraX, intraCoefficients, database.size()),
+				makeCurve("Extra-Speaker", *extraHistogram, extraX, extraCoefficients, database.size())
+			};
+			QString error;
+			if(!saveDatabase(parser.value(outputOption), database, curves, error)){
+				err() << error << endl;
+				return 1;
+			}
+			out() << "Saved the database to " << parser.value(outputOption) << endl;
+		}
+	}
+	out() << "Intra-speaker coefficients: " << toString(intraCoefficients) << endl;
+	out() << "Extra-speaker coefficients: " << toString(extraCoefficients) << endl;
+	if(arguments.size() < 2) return 0;
+	// Match the unknown voices against every file in the database
+	auto unknown = extractFolder(arguments.at(1), threads, recordThreads, cacheFolder);
+	if(unknown.isEmpty()){
+		err() << "No audio files in " << arguments.at(1) << endl;
+		return 1;
+	}
+	timer.restart();
+	if(parser.isSet(eachOption)){
+		// Score the unknown files one by one, against the database statistics loaded once
+		AA::MatchingService::Parameters MatchPars;
+		MatchPars.BarStep = QSettings().value("Histogram/BarStep", 0.02).toDouble();
+		MatchPars.LeftExtremum = QSettings().value("Histogram/MinimumValue", 0.0).toDouble();
+		MatchPars.RightExtremum = QSettings().value("Histogram/MaximumValue", 2.0).toDouble();
+		MatchPars.NumberThreads = threads;
+		AA::MatchingService service(summaries, intraCoefficients, extraCoefficients, MatchPars);
+		QVector<AA::FeaturesSummary> unknownSummaries;
+		for(const auto& extraction: unknown) unknownSummaries << extraction.summary;
+		const auto matches = service.match(unknownSummaries);
+		const double seconds = timer.nsecsElapsed() * 1e-9;
+		for(int u = 0; u < unknown.size(); ++u){
+			const auto& match = matches[u];
+			out() << unknown[u].file << "\t";
+			if(match.Score >= 0.0) out() << match.Score*100.0 << "%";
+			else out() << "INCONCLUSIVE";
+			if(match.Closest >= 0) out() << "\tclosest " << database[match.Closest].file << "\t" << match.ClosestDistance;
+			out() << endl;
+		}
+		out() << "Matched " << unknown.size() << " files against " << database.size() << " in " << seconds << " s: "
+		<< unknown.size() / seconds << " files/s" << endl;
+		return 0;
+	}
+	// Both database curves are compared with the same unknown-database distances, binned as they are
+	// computed in per-thread histograms (the range is the default one of UMF::ComputeHistogram)
+	const double barStep = QSettings().value("Histogram/BarStep", 0.02).toDouble();
+	std::vector<UMF::HistogramAccumulator> histograms(threads, UMF::HistogramAccumulator(0.0, 2.0, barStep));
+	// Threads share the unknown files, each one compared with the whole database
+	UMF::parallelFor(0, unknown.size(), 1, threads, [&](int begin, int end, int w){
+		for(int u = begin; u < end; ++u)
+			for(const auto& extraction: database)
+				histograms[w].add(AA::FeaturesDistance::compute(unknown.at(u).summary, extraction.summary));
+	});
+	for(int w = 1; w < threads; ++w) histograms[0] += histograms[w];
+	QVector<double> X, Y;
+	histograms[0].getHistogram(X, Y, false, true);
+	auto test = AA::ComputeProbability::create({
+		{"IntraCoefficients", QVariant::fromValue(intraCoefficients)},
+		{"ExtraCoefficients", QVariant::fromValue(extraCoefficients)},
+		{"LeftExtremum", QSettings().value("Histogram/MinimumValue", 0.0)},
+		{"RightExtremum", QSettings().value("Histogram/MaximumValue", 2.0)},
+		{"IntraX", QVariant::fromValue(X)},
+		{"IntraY", QVariant::fromValue(Y)},
+		{"ExtraX", QVariant::fromValue(X)},
+		{"ExtraY", QVariant::fromValue(Y)}
+	});
+	test->run();
+	const double seconds = timer.nsecsElapsed() * 1e-9;
+	out() << "Matched " << unknown.size() << " files against " << database.size() << " in " << seconds << " s" << endl;
+	if(test->getOutMatchingScore() >= 0.0){
+		out() << "The unknown voice belongs to the speaker with "
+		<< test->getOutMatchingScore()*100.0 << "% probability" << endl;
+	}else{
+		out() << "INCONCLUSIVE" << endl;
+	}
+	return 0;
+}
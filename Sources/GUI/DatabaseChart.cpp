@@ -19,6 +19,7 @@ void GUI::DatabaseLine::update(){
 			});
 			evaluation << UMF::CurveNormalization::create({
 				{"LeftExtremum", min}, {"RightExtremum", max},
+				{"Model", UMF::CurveNormalization::gauss},
 				{"Coefficients", QVariant::fromValue(getCoefficients())}
 			});
 			evaluation->serialExecution();
@@ -49,6 +50,98 @@ void GUI::DatabaseLine::update(){
 	}
 }
 
+void GUI::DatabaseLine::setFeatures(QList<QVector<double>> features){
+	m_Database.reset();
+	m_Features = features;
+	// Summarize every file once, so that distances from the database cost constant time
+	m_Summaries.resize(m_Features.size());
+	for(int k = 0; k < m_Features.size(); ++k)
+		m_Summaries[k] = AA::FeaturesSummary::fromFeatures(m_Features[k]);
+	// Groups and names are unknown
+	m_Groups.fill(0, m_Features.size());
+	m_FileNames.clear();
+	for(int k = 0; k < m_Features.size(); ++k) m_FileNames << QString();
+	Q_EMIT featuresChanged();
+}
+
+void GUI::DatabaseLine::addFeatures(QVector<double> features, AA::FeaturesSummary summary, int group, QString fileName){
+	// Files added to the ones of a database follow them, which stay in place
+	m_Features << features;
+	m_Summaries << summary;
+	m_Groups << group;
+	m_FileNames << fileName;
+	Q_EMIT featuresChanged();
+}
+
+void GUI::DatabaseLine::setDatabase(QSharedPointer<const AA::DatabaseFile> database, int first, int count){
+	m_Features.clear();
+	m_Summaries.clear();
+	m_Groups.clear();
+	m_FileNames.clear();
+	m_Database = database;
+	m_FirstFile = first;
+	m_NumberFiles = count;
+	Q_EMIT featuresChanged();
+}
+
+QList<QVector<double>> GUI::DatabaseLine::getFeatures() const{
+	if(!m_Database) return m_Features;
+	QList<QVector<double>> features;
+	features.reserve(getNumberFiles());
+	for(int k = m_FirstFile; k < m_FirstFile + m_NumberFiles; ++k){
+		qint64 size;
+		const double* F = m_Database->getFeatures(k, size);
+		features << QVector<double>(F, F + size);
+	}
+	return features + m_Features;
+}
+
+QVector<AA::FeaturesSummary> GUI::DatabaseLine::getSummaries() const{
+	if(!m_Database) return m_Summaries;
+	QVector<AA::FeaturesSummary> summaries(m_NumberFiles);
+	for(int k = 0; k < m_NumberFiles; ++k) summaries[k] = m_Database->getSummary(m_FirstFile + k);
+	return summaries + m_Summaries;
+}
+
+QVector<int> GUI::DatabaseLine::getGroups() const{
+	if(!m_Database) return m_Groups;
+	QVector<int> groups(m_NumberFiles);
+	for(int k = 0; k < m_NumberFiles; ++k) groups[k] = m_Database->getGroup(m_FirstFile + k);
+	return groups + m_Groups;
+}
+
+QStringList GUI::DatabaseLine::getFileNames() const{
+	if(!m_Database) return m_FileNames;
+	QStringList names;
+	for(int k = m_FirstFile; k < m_FirstFile + m_NumberFiles; ++k) names << m_Database->getName(k);
+	return names + m_FileNames;
+}
+
+QVector<AA::DatabaseFile::File> GUI::DatabaseLine::getFiles() const{
+	QVector<AA::DatabaseFile::File> files(getNumberFiles());
+	const int mapped = m_Database ? m_NumberFiles : 0;
+	for(int k = 0; k < files.size(); ++k){
+		if(k < mapped){
+			files[k] = m_Database->getFile(m_FirstFile + k);
+			continue;
+		}
+		const int f = k - mapped;
+		files[k].Features = m_Features[f].constData();
+		files[k].Size = m_Features[f].size();
+		files[k].Summary = m_Summaries[f];
+		files[k].Group = m_Groups[f];
+		files[k].Name = m_FileNames[f];
+	}
+	return files;
+}
+
+void GUI::DatabaseLine::setHistogram(double minimum, double maximum, double step, QVector<double> counts){
+	m_HistogramMinimum = minimum;
+	m_HistogramMaximum = maximum;
+	m_BarStep = step;
+	m_Counts = counts;
+}
+
 QVector<double> GUI::DatabaseLine::linspace(double min, double max, int N){
 	QVector<double> X;
 	auto step = (max-min)/(N-1);
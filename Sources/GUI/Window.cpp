@@ -46,8 +46,8 @@ fileCount(0) {
 	// Set charts index conversion functions
 	ui->ChartShowRec->indexToXAxis = [extractor](int k){
 		const auto& SampleRate = extractor->getOutSampleRate();
-		const auto& RecLength = extractor->getOutRecordLength();
-		return double(RecLength * extractor->getSelectRecord() + k) / double(SampleRate);
+		const auto& RecHop = extractor->getOutRecordHop();
+		return double(RecHop * extractor->getSelectRecord() + k) / double(SampleRate);
 	};
 	ui->ChartShowRecSpectrum->indexToXAxis = [extractor](int k){
 		const auto& SampleRate = extractor->getOutSampleRate();
@@ -203,6 +203,36 @@ void GUI::Window::on_DBFilesLineEdit_textChanged(const QString &text){
 }
 
 void GUI::Window::on_DBCreateButton_clicked(){
+	createDatabase(Q_NULLPTR, Q_NULLPTR);
+}
+
+void GUI::Window::on_DBEnrollButton_clicked(){
+	// The lines with the given name, as named when created here or by cava-cli
+	GUI::DatabaseLine *intraLine = 0, *extraLine = 0;
+	auto isNamed = [this](const QString& name, const QString& title){
+		return name == title+" Fitting "+ui->DBPlotName->text() || name == (title+" "+ui->DBPlotName->text()).trimmed();
+	};
+	for(auto s: ui->DBChartView->chart()->series()){
+		if(auto line = dynamic_cast<GUI::DatabaseLine*>(s); line){
+			if(isNamed(line->name(), "Intra-Speaker"))
+				intraLine = line;
+			else if(isNamed(line->name(), "Extra-Speaker"))
+				extraLine = line;
+		}
+	}
+	if(!intraLine || !extraLine){
+		popupErrorWindow("Create or load a database with the given name first");
+	}
+	if(intraLine->getCounts().isEmpty() || extraLine->getCounts().isEmpty()){
+		popupErrorWindow("The database has no histograms of its distances, it must be created again");
+	}
+	if(intraLine->getNumberFiles() != extraLine->getNumberFiles()){
+		popupErrorWindow("The intra-speaker and extra-speaker curves of the database have different files");
+	}
+	createDatabase(intraLine, extraLine);
+}
+
+void GUI::Window::createDatabase(GUI::DatabaseLine* intraLine, GUI::DatabaseLine* extraLine){
 	// Check if it input is empty
 	if (ui->DBFilesLineEdit->text().isEmpty()){
 		popupErrorWindow("An input folder must be chosen");
@@ -211,6 +241,19 @@ void GUI::Window::on_DBCreateButton_clicked(){
 	if(foundFiles.isEmpty()) {
 		popupErrorWindow("Empty directory");
 	}
+	const bool enrolling = intraLine && extraLine;
+	// When enrolling, the files already in the database are skipped, and the subdirectories named as the
+	// directory of a database speaker are the same speaker
+	QSet<QString> enrolledFiles;
+	QHash<QString, int> speakers;
+	int numberGroups = 0;
+	if(enrolling){
+		for(const auto& file: intraLine->getFiles()){
+			enrolledFiles.insert(QFileInfo(file.Name).absoluteFilePath());
+			speakers.insert(QFileInfo(file.Name).absoluteDir().dirName(), file.Group);
+			numberGroups = std::max(numberGroups, file.Group + 1);
+		}
+	}
 	// Create activity indicator
 	auto progressDialog = new QProgressDialog("Processing files...", QString(), 0, 0, this);
 	progressDialog->setValue(0);
@@ -223,189 +266,133 @@ void GUI::Window::on_DBCreateButton_clicked(){
 		{"SelectRecord", -1}
 	};
 	FEPars.unite(getPropsInGroup("FeaturesExtraction"));
+	// Reuse the features extracted by previous runs with the same parameters
+	FEPars.insert("CacheFolder", AA::FeaturesCache::defaultFolder());
 	// Collect histogram paramters for later use
 	auto HistPars = getPropsInGroup("Histogram");
-	HistPars.insert("OITable", QVariant::fromValue(QMapStringString({{"Distance","Values"}})));
 	// Collect fitting parameters for later use
 	auto fittingPars = getPropsInGroup("Fitting");
 	fittingPars.insert("KeepInput", true);
 	fittingPars.insert("OITable", QVariant::fromValue(QMapStringString({{"HistX","X"},{"HistY","Y"}})));
-	// Declare a list of extractors (this intermediate step will avoid reloading files and recomputing the features)
-	// extractors will have the same structure of dirContent (1-1 correspondance)
-	int n_extractor = 0;
-	QList<QList<QSharedPointer<AA::FeaturesExtractor>>> extractors;
-	for(const auto& dir: foundFiles){// foreach subdir
-		// Create a new sublist
-		extractors << QList<QSharedPointer<AA::FeaturesExtractor>>();
-		for(const auto& file: dir){ // foreach file
+	// Declare a list of extractors, one per file, and the group (subdirectory) of each file
+	QList<QSharedPointer<AA::FeaturesExtractor>> extractors;
+	QVector<int> groups;
+	// Count the distances of each kind, each unordered pair once
+	qint64 n_int_dist = 0;
+	for(int g = 0; g < foundFiles.size(); ++g){// foreach subdir
+		int group = g;
+		if(enrolling && !foundFiles[g].isEmpty()){
+			const auto speaker = QFileInfo(foundFiles[g].first()).absoluteDir().dirName();
+			if(!speakers.contains(speaker)) speakers.insert(speaker, numberGroups++);
+			group = speakers.value(speaker);
+		}
+		for(const auto& file: foundFiles[g]){ // foreach file
+			if(enrolledFiles.contains(QFileInfo(file).absoluteFilePath())) continue;
 			// Set current file as input to an audio reader instance
-			// Extract features after the reader has completed its task
 			FEPars["File"] = file;
 			auto extractor = AA::FeaturesExtractor::create(FEPars);
-			++n_extractor;
 			extractor->setObjectName(QFileInfo(file).baseName());
-			// Add to extractors to the last sublist created
-			extractors.last() << extractor;
 			// Connect the extractor with the progress dialog
 			connect(extractor.data(), &QAlgorithm::justFinished, this/*context*/, pbStepUp, Qt::QueuedConnection);
+			extractors << extractor;
+			groups << group;
 		}
+		n_int_dist += qint64(foundFiles[g].size()) * (foundFiles[g].size() - 1) / 2;
+	}
+	const qint64 n_ext_dist = qint64(extractors.size()) * (extractors.size() - 1) / 2 - n_int_dist;
+	if(extractors.isEmpty()){
+		delete progressDialog;
+		popupErrorWindow("No new files to add to the database");
 	}
 	// Update progress dialog's maximum
-	progressDialog->setMaximum(progressDialog->maximum()+n_extractor);
-	// Intra-speaker features
-	{
+	progressDialog->setMaximum(progressDialog->maximum()+extractors.size());
+	// The distributions are the histograms of the distances between every pair of files of the
+	// given kind, computed at once when all the features are available, and then fitted; when
+	// enrolling, only the pairs with a new file are computed and added to the histograms of the lines
+	QList<GUI::DatabaseLine*> lines;
+	QList<QSharedPointer<AA::PairwiseDistances>> histComputes;
+	QList<QSharedPointer<UMF::FittingGaussExp>> fittings;
+	auto addDistribution = [&](const QString& name, const QString& title, AA::PairwiseDistances::pairs pairs, GUI::DatabaseLine* line){
 		// Create a new database line to store the features computed
-		auto line = new DatabaseLine;
-		line->setColor(DatabaseLine::genNewColor());
-		line->setName("Intra-Speaker Fitting "+ui->DBPlotName->text());
-		line->setType(GUI::DatabaseLine::GaussianExp);
-		line->setNumPoints(QSettings().value("Plot/Points").toInt());
-		// Create an histogram series
-		auto histogram = new QHistogramSeries;
-		histogram->setColor(line->color().darker());
-		histogram->setBorderColor(QColor(0,0,0,0)/*transparent*/);
-		histogram->setName("Intra-Speaker Histogram "+ui->DBPlotName->text());
-		// Compute the histogram of all the intra-speaker distances
-		auto histCompute = UMF::ComputeHistogram::create(HistPars);
-		histCompute->setObjectName("Intra histogram");
-		// Compute the number of distances used for extra-speaker distribution
-		int n_int_dist = 0;
-		// Define a map of already used pairs to avoid to compute the same distance twice
-		QSet<QSet<QAlgorithm*>> used_pairs;
-		for(auto& dir: extractors){
-			for(auto& outerExtractor: dir){
-				// Store the features into the database line
-				connect(outerExtractor.data(), &QAlgorithm::justFinished, this, [line,outerExtractor](){
-					line->addFeatures(outerExtractor->getOutFeatures());
-				});
-				// Scan the files in the directory again and compute the distance
-				// between each couple of features array
-				for(auto& innerExtractor: dir){
-					// Some checks:
-					auto sameFile = (outerExtractor == innerExtractor); // outer-inner are the same file
-					auto alreadyUsedPairs = used_pairs.contains({outerExtractor.data(), innerExtractor.data()});
-					if(!sameFile && !alreadyUsedPairs){
-						// Distance calculator
-						auto distanceCalculator = AA::FeaturesDistance::create();
-						outerExtractor >> distanceCalculator;
-						innerExtractor >> distanceCalculator >> histCompute;
-						distanceCalculator->setObjectName(outerExtractor->objectName().replace(" extract", "")+"-"+innerExtractor->objectName().replace(" extract", ""));
-						// Increment the files number
-						n_int_dist++;
-						// Add this pair of extractors to used_pairs
-						used_pairs << QSet<QAlgorithm*>({outerExtractor.data(), innerExtractor.data()});
-					}
-				}
-			}
+		if(!line){
+			line = new DatabaseLine;
+			line->setColor(DatabaseLine::genNewColor());
+			line->setName(title+" Fitting "+ui->DBPlotName->text());
+			line->setType(GUI::DatabaseLine::GaussianExp);
+			line->setNumPoints(QSettings().value("Plot/Points").toInt());
 		}
-		// Proceed only if there is at least one distance to process
-		if (n_int_dist > 0){
-			// When the histogram is computed draw the histogram
-			connect(histCompute.data(), &UMF::ComputeHistogram::histogramReady, this/*as context*/,
-					[this, histogram](QVector<double> Bin, QVector<double> Count){
-						histogram->setX(Bin);
-						histogram->setY(Count);
-						ui->DBChartView->updateViewWith(histogram);
-					}, Qt::QueuedConnection);
-			// Change output names and perform fitting
-			auto intraFitting = UMF::FittingGaussExp::create(fittingPars);
-			intraFitting->setObjectName("IntraFitting");
-			histCompute >> intraFitting;
-			// Extend the maximum value in the progress dialog
-			progressDialog->setMaximum(progressDialog->maximum()+1);
-			// Connect the fitting instance to the progress dialog
-			connect(intraFitting.data(), &QAlgorithm::justFinished, this/*context*/, pbStepUp, Qt::QueuedConnection);
-			// When the fitting algorithm finishes call on_DBCreated and plot the fitted curve
-			connect(intraFitting.data(), &UMF::Fitting1D::fittingReady, this/*as context*/,
-					[this, line](QVector<double> C, double min, double max){
-						line->setMinimum(min);
-						line->setMaximum(max);
-						line->setCoefficients(C);
-						ui->DBChartView->updateViewWith(line);
-					}, Qt::QueuedConnection);
-			QAlgorithm::improveTree(intraFitting.data());
-			intraFitting->parallelExecution();
-		}
-	}
-	// Extra-speaker features
-	{
-		// Create a new database line to store the features computed
-		auto line = new DatabaseLine;
-		line->setColor(DatabaseLine::genNewColor());
-		line->setName("Extra-Speaker Fitting "+ui->DBPlotName->text());
-		line->setType(GUI::DatabaseLine::GaussianExp);
-		line->setNumPoints(QSettings().value("Plot/Points").toInt());
 		// Create an histogram series
 		auto histogram = new QHistogramSeries;
 		histogram->setColor(line->color().darker());
 		histogram->setBorderColor(QColor(0,0,0,0)/*transparent*/);
-		histogram->setName("Extra-Speaker Histogram "+ui->DBPlotName->text());
-		// Compute the histogram of all the extra-speaker distances
-		auto histCompute = UMF::ComputeHistogram::create(HistPars);
-		histCompute->setObjectName("Extra histogram");
-		// Compute the number of distances used for extra-speaker distribution
-		int n_ext_dist = 0;
-		// Define a map of already used pairs to avoid to compute the same distance twice
-		QSet<QSet<QAlgorithm*>> used_pairs;
-		for(auto& outerDir: extractors){
-			for(auto& outerExtractor: outerDir){
-				// Store the features into the database line
-				connect(outerExtractor.data(), &QAlgorithm::justFinished, this, [line,outerExtractor](){
-					line->addFeatures(outerExtractor->getOutFeatures());
-				});
-				// Scan the files in the directory again and compute the distance
-				// between each couple of features array
-				for(auto& innerDir: extractors){
-					// The intra-speaker distances are not to be considered here
-					// so skip if the dictories are the same
-					if(outerDir == innerDir) continue;
-					for(auto& innerExtractor: innerDir){
-						// Some checks:
-						auto sameFile = (outerExtractor == innerExtractor); // outer-inner are the same file
-						auto alreadyUsedPairs = used_pairs.contains({outerExtractor.data(), innerExtractor.data()});
-						if(!sameFile && !alreadyUsedPairs){
-							// Distance calculator
-							auto distanceCalculator = AA::FeaturesDistance::create();
-							outerExtractor >> distanceCalculator;
-							innerExtractor >> distanceCalculator >> histCompute;
-							distanceCalculator->setObjectName(outerExtractor->objectName().replace(" extract", "")+"-"+innerExtractor->objectName().replace(" extract", ""));
-							// Increment the files number
-							n_ext_dist++;
-							// Add this pair of extractors to used_pairs
-							used_pairs << QSet<QAlgorithm*>({outerExtractor.data(), innerExtractor.data()});
-						}
-					}
-				}
-			}
-		}
-		// Proceed only if there is at least one distance to process
-		if (n_ext_dist > 0){
-			// When the histogram is computed draw the histogram
-			connect(histCompute.data(), &UMF::ComputeHistogram::histogramReady, this/*as context*/,
-					[this, histogram](QVector<double> Bin, QVector<double> Count){
-						histogram->setX(Bin);
-						histogram->setY(Count);
-						ui->DBChartView->updateViewWith(histogram);
-					}, Qt::QueuedConnection);
-			// Change output names and perform fitting
-			auto extraFitting = UMF::FittingGaussExp::create(fittingPars);
-			extraFitting->setObjectName("ExtraFitting");
-			histCompute >> extraFitting;
-			// Extend the maximum value in the progress dialog
-			progressDialog->setMaximum(progressDialog->maximum()+1);
-			// Connect the fitting instance to the progress dialog
-			connect(extraFitting.data(), &QAlgorithm::justFinished, this/*context*/, pbStepUp, Qt::QueuedConnection);
-			// When the fitting algorithm finishes call on_DBCreated and plot the fitted curve
-			connect(extraFitting.data(), &UMF::Fitting1D::fittingReady, this/*as context*/,
-					[this, line](QVector<double> C, double min, double max){
-						line->setMinimum(min);
-						line->setMaximum(max);
-						line->setCoefficients(C);
-						ui->DBChartView->updateViewWith(line);
-					}, Qt::QueuedConnection);
-			QAlgorithm::improveTree(extraFitting.data());
-			extraFitting->parallelExecution();
+		histogram->setName(title+" Histogram "+ui->DBPlotName->text());
+		// Compute the histogram of all the distances
+		auto histCompute = AA::PairwiseDistances::create(HistPars);
+		histCompute->setPairs(pairs);
+		histCompute->setObjectName(name+" histogram");
+		if(enrolling){
+			histCompute->setMinimumValue(line->getHistogramMinimum());
+			histCompute->setMaximumValue(line->getHistogramMaximum());
+			histCompute->setBarStep(line->getBarStep());
+			histCompute->setNumberEnrolled(line->getNumberFiles());
+			histCompute->setInEnrolledCounts(line->getCounts());
 		}
+		// When the histogram is computed draw the histogram, in place of the previous one
+		connect(histCompute.data(), &AA::PairwiseDistances::histogramReady, this/*as context*/,
+				[this, histogram](QVector<double> Bin, QVector<double> Count){
+					for(auto series: ui->DBChartView->chart()->series()){
+						if(series->name() != histogram->name()) continue;
+						ui->DBChartView->chart()->removeSeries(series);
+						delete series;
+					}
+					histogram->setX(Bin);
+					histogram->setY(Count);
+					ui->DBChartView->updateViewWith(histogram);
+				}, Qt::QueuedConnection);
+		// Change output names and perform fitting
+		auto fitting = UMF::FittingGaussExp::create(fittingPars);
+		fitting->setObjectName(name+"Fitting");
+		histCompute >> fitting;
+		// Extend the maximum value in the progress dialog
+		progressDialog->setMaximum(progressDialog->maximum()+1);
+		// Connect the fitting instance to the progress dialog
+		connect(fitting.data(), &QAlgorithm::justFinished, this/*context*/, pbStepUp, Qt::QueuedConnection);
+		// When the fitting algorithm finishes plot the fitted curve, and keep the histogram to enroll more files
+		connect(fitting.data(), &UMF::Fitting1D::fittingReady, this/*as context*/,
+				[this, line, histCompute](QVector<double> C, double min, double max){
+					line->setMinimum(min);
+					line->setMaximum(max);
+					line->setCoefficients(C);
+					line->setHistogram(histCompute->getMinimumValue(), histCompute->getMaximumValue(),
+									   histCompute->getBarStep(), histCompute->getOutCounts());
+					ui->DBChartView->updateViewWith(line);
+				}, Qt::QueuedConnection);
+		lines << line;
+		histComputes << histCompute;
+		fittings << fitting;
+	};
+	// Proceed only if there is at least one distance to process
+	if (enrolling || n_int_dist > 0) addDistribution("Intra", "Intra-Speaker", AA::PairwiseDistances::intra, intraLine);
+	if (enrolling || n_ext_dist > 0) addDistribution("Extra", "Extra-Speaker", AA::PairwiseDistances::extra, extraLine);
+	// Extract the features of every file; when the last one is ready compute the distributions
+	auto remaining = QSharedPointer<int>::create(extractors.size());
+	for(int n = 0; n < extractors.size(); ++n){
+		const auto& extractor = extractors[n];
+		const int group = groups[n];
+		connect(extractor.data(), &QAlgorithm::justFinished, this/*context*/,
+				[=](){
+					// Store the features into the database lines
+					for(auto line: lines) line->addFeatures(extractor->getOutFeatures(), extractor->getOutSummary(), group, extractor->getFile());
+					if(--*remaining > 0) return;
+					// The lines hold the files enrolled before, followed by the new ones
+					for(int k = 0; k < histComputes.size(); ++k){
+						histComputes[k]->setInSummaries(lines[k]->getSummaries());
+						histComputes[k]->setInGroups(lines[k]->getGroups());
+						QAlgorithm::improveTree(fittings[k].data());
+						fittings[k]->parallelExecution();
+					}
+				}, Qt::QueuedConnection);
+		extractor->parallelExecution();
 	}
 	progressDialog->exec();
 }
@@ -426,22 +413,60 @@ void GUI::Window::on_DBSaveButton_clicked(){
 }
 
 void GUI::Window::on_DBLoadButton_clicked(){
-	QString fileName = QFileDialog::getOpenFileName(this, "Choose origin file name", QDir::currentPath(), "Text files (*.txt)");
+	QString fileName = QFileDialog::getOpenFileName(this, "Choose origin file name", QDir::currentPath(), "Databases (*.cavadb);;All files (*)");
 	if (!fileName.isEmpty()){ // Check if the user pressed cancel
-		// Save the database to that file
+		// Read the lines but no settings, and show the curves on the chart
+		for(auto line: loadDatabase(fileName, false))
+			ui->DBChartView->updateViewWith(line);
+	}
+}
+
+QList<GUI::DatabaseLine*> GUI::Window::loadDatabase(const QString& fileName, bool loadSettings){
+	QList<GUI::DatabaseLine*> lines;
+	// Previous versions stored two lines and the settings with QDataStream
+	if(!AA::DatabaseFile::isDatabaseFile(fileName)){
 		QFile file(fileName);
-		if(file.open(QFile::ReadOnly)){
-			// Read two lines but no settings
-			auto lineIntra = new GUI::DatabaseLine;
-			auto lineExtra = new GUI::DatabaseLine;
-			QDataStream istream(&file);
-			istream >> *lineIntra >> *lineExtra;
-			file.close();
-			// Show the curves on the chart
-			ui->DBChartView->updateViewWith(lineIntra);
-			ui->DBChartView->updateViewWith(lineExtra);
+		if(!file.open(QFile::ReadOnly)){
+			popupError("Unable to open "+fileName);
+			return lines;
+		}
+		auto lineIntra = new GUI::DatabaseLine;
+		auto lineExtra = new GUI::DatabaseLine;
+		QDataStream istream(&file);
+		istream >> *lineIntra >> *lineExtra;
+		if(loadSettings){
+			QSettings settings;
+			istream >> settings;
 		}
+		return lines << lineIntra << lineExtra;
 	}
+	// The database is mapped, and shared by the lines until the last one is destroyed
+	auto database = QSharedPointer<AA::DatabaseFile>::create();
+	if(!database->open(fileName)){
+		popupError(database->getError());
+		return lines;
+	}
+	for(int c = 0; c < database->getNumberCurves(); ++c){
+		const auto curve = database->getCurve(c);
+		auto line = new GUI::DatabaseLine;
+		line->setName(curve.Name);
+		line->setType(curve.Model == UMF::CurveNormalization::gauss ? GUI::DatabaseLine::Gaussian : GUI::DatabaseLine::GaussianExp);
+		// Curves saved by cava-cli have no color
+		line->setColor(curve.Color != 0 ? QColor::fromRgba(curve.Color) : GUI::DatabaseLine::genNewColor());
+		line->setMinimum(curve.Minimum);
+		line->setMaximum(curve.Maximum);
+		line->setCoefficients(curve.Coefficients);
+		line->setDatabase(database, curve.FirstFile, curve.NumberFiles);
+		line->setHistogram(curve.HistogramMinimum, curve.HistogramMaximum, curve.BarStep, curve.Counts);
+		lines << line;
+	}
+	if(loadSettings){
+		QSettings settings;
+		const auto parameters = database->getParameters();
+		for(auto i = parameters.constBegin(); i != parameters.constEnd(); ++i)
+			settings.setValue(i.key(), i.value());
+	}
+	return lines;
 }
 
 void GUI::Window::on_PlotCtrlCleanButton_clicked(){
@@ -482,6 +507,8 @@ void GUI::Window::on_MCtrlMatchButton_clicked(){
 		{"SelectRecord", -1}
 	};
 	FEPars.unite(getPropsInGroup("FeaturesExtraction"));
+	// Reuse the features extracted by previous runs with the same parameters
+	FEPars.insert("CacheFolder", AA::FeaturesCache::defaultFolder());
 	// Get the list of unknown voice file paths
 	QStringList MUScanFlattened;
 	{
@@ -495,26 +522,6 @@ void GUI::Window::on_MCtrlMatchButton_clicked(){
 		for(auto lst: MUScanContent) MUScanFlattened << lst;
 		if(MUScanFlattened.isEmpty()) popupErrorWindow("No audio files in Unknown directory");
 	}
-	// Define the histogram algorithm
-	QAlgorithm::PropertyMap HistogramSettings = {
-		QAlgorithm::makeOITable({{"Distance","Values"}}),
-		{"BarStep", QSettings().value("Histogram/BarStep")},
-		{"SuppressZeroCount", false}
-	};
-	auto HistogramIntra = UMF::ComputeHistogram::create(HistogramSettings);
-	auto HistogramExtra = UMF::ComputeHistogram::create(HistogramSettings);
-	HistogramIntra->setObjectName("Intra");
-	HistogramExtra->setObjectName("Extra");
-	// Declare and initialize the total number of files
-	QList<QSharedPointer<AA::FeaturesExtractor>> MUExtractors;
-	for(auto MUFile: MUScanFlattened){
-		FEPars["File"] = MUFile;
-		auto MUExtract = AA::FeaturesExtractor::create(FEPars);
-		// Connect the extractor to the progress dialog
-		connect(MUExtract.data(), &QAlgorithm::justFinished, this/*context*/, pbStepUp, Qt::QueuedConnection);
-		// Add to the list
-		MUExtractors << MUExtract;
-	}
 	// Take information from the lines in the chart
 	GUI::DatabaseLine *intraLine = 0, *extraLine = 0;
 	for(auto s: ui->MatchingChartView->chart()->series()){
@@ -528,42 +535,18 @@ void GUI::Window::on_MCtrlMatchButton_clicked(){
 	if(!intraLine || !extraLine){
 		popupErrorWindow("Load some database on the chart first");
 	}
-	// Update the maximum value for the progress dialog
-	progressDialog->setMaximum(MUExtractors.size()/*file readings*/ +
-							   MUExtractors.size()*(intraLine->getFeatures().size()+extraLine->getFeatures().size())/*dist. calc.*/ +
-							   1/*final algorithms*/);
-	// Create the distance calculators and connect them to the extractors
-	for(auto MUExtract: MUExtractors){
-		for(auto IntraFeatures: intraLine->getFeatures()){
-			auto DistCalculator = AA::FeaturesDistance::create();
-			// Assign the first features array in the distance calculator
-			DistCalculator->setInFeatures(IntraFeatures);
-			// Link algorithms
-			MUExtract >> DistCalculator >> HistogramIntra;
-			// Connect the extractor to the progress dialog
-			connect(DistCalculator.data(), &QAlgorithm::justFinished, this/*context*/, pbStepUp, Qt::QueuedConnection);
-		}
-		for(auto ExtraFeatures: extraLine->getFeatures()){
-			auto DistCalculator = AA::FeaturesDistance::create();
-			// Assign the first features array in the distance calculator
-			DistCalculator->setInFeatures(ExtraFeatures);
-			// Link algorithms
-			MUExtract >> DistCalculator >> HistogramExtra;
-			// Connect the extractor to the progress dialog
-			connect(DistCalculator.data(), &QAlgorithm::justFinished, this/*context*/, pbStepUp, Qt::QueuedConnection);
-		}
+	// Declare and initialize the total number of files
+	QList<QSharedPointer<AA::FeaturesExtractor>> MUExtractors;
+	for(auto MUFile: MUScanFlattened){
+		FEPars["File"] = MUFile;
+		auto MUExtract = AA::FeaturesExtractor::create(FEPars);
+		// Connect the extractor to the progress dialog
+		connect(MUExtract.data(), &QAlgorithm::justFinished, this/*context*/, pbStepUp, Qt::QueuedConnection);
+		// Add to the list
+		MUExtractors << MUExtract;
 	}
-	// Connections - plot the histograms
-	connect(HistogramIntra.data(), &UMF::ComputeHistogram::histogramReady, this/*context*/,
-			[this](QVector<double> Bin, QVector<double> Count){
-				QString Name("Intra-Unknown Distances Histogram");
-				ui->MatchingChartView->plotHistogram(Bin, Count, Name);
-			}, Qt::QueuedConnection);
-	connect(HistogramExtra.data(), &UMF::ComputeHistogram::histogramReady, this/*context*/,
-			[this](QVector<double> Bin, QVector<double> Count){
-				QString Name("Extra-Unknown Distances Histogram");
-				ui->MatchingChartView->plotHistogram(Bin, Count, Name);
-			}, Qt::QueuedConnection);
+	// Update the maximum value for the progress dialog
+	progressDialog->setMaximum(MUExtractors.size()/*file readings*/ + 1/*final algorithms*/);
 	// Specify the test properties
 	auto Test = AA::ComputeProbability::create({
 		{"IntraCoefficients", QVariant::fromValue<QVector<double>>(intraLine->getCoefficients())},
@@ -578,10 +561,7 @@ void GUI::Window::on_MCtrlMatchButton_clicked(){
 		})
 	});
 	Test->setObjectName("FinalTest");
-	// Connect the algorithms
-	HistogramIntra >> Test;
-	HistogramExtra >> Test;
-	// Connections - final result
+	// Connections - final result
 	connect(Test.data(), &QAlgorithm::justFinished, this, [this, Test](){
 		// Get previous label
 		QString label = ui->MatchingResultsLabel->text();
@@ -594,10 +574,55 @@ void GUI::Window::on_MCtrlMatchButton_clicked(){
 		// Set the result text
 		ui->MatchingResultsLabel->setText(label);
 	});
-	// Connect the two tests to the progress dialog
+	// Connect the test to the progress dialog
 	connect(Test.data(), &QAlgorithm::justFinished, this/*context*/, pbStepUp, Qt::QueuedConnection);
-	// Make them start
-	Test->parallelExecution();
+	// When every unknown file has been processed compare their summaries with the database ones,
+	// without going through the features again; the database files are indexed meanwhile
+	const auto intraIndex = QSharedPointer<const AA::SpeakerIndex>::create(intraLine->getSummaries());
+	const auto extraIndex = QSharedPointer<const AA::SpeakerIndex>::create(extraLine->getSummaries());
+	auto remaining = QSharedPointer<int>::create(MUExtractors.size());
+	for(auto& MUExtract: MUExtractors){
+		connect(MUExtract.data(), &QAlgorithm::justFinished, this/*context*/,
+				[=]() mutable {
+					if(--*remaining > 0) return;
+					// Compute the distances and their histograms
+					auto computeHistogram = [&](const AA::SpeakerIndex& database, const QString& name){
+						auto histogram = UMF::ComputeHistogram::create({
+							{"BarStep", QSettings().value("Histogram/BarStep")},
+							{"SuppressZeroCount", false}
+						});
+						histogram->setObjectName(name);
+						// Only the distances within the histogram range are computed; a single infinite one
+						// stands for the farther files, as the histogram is cropped to the largest distance
+						const double radius = histogram->getMaximumValue();
+						QVector<QVector<double>> found(MUExtractors.size());
+						auto output = found.data();
+						UMF::parallelFor(0, MUExtractors.size(), 1, 0, [&](int begin, int end, int){
+							QVector<AA::SpeakerIndex::Neighbor> neighbors;
+							for(int u = begin; u < end; ++u){
+								const int farther = database.withinRadius(MUExtractors[u]->getOutSummary(), radius, neighbors);
+								output[u].reserve(neighbors.size() + 1);
+								for(const auto& neighbor: neighbors) output[u] << neighbor.Distance;
+								if(farther > 0) output[u] << std::numeric_limits<double>::infinity();
+							}
+						});
+						QVector<double> distances;
+						for(const auto& values: found) distances << values;
+						histogram->setInValues(distances);
+						// Plot the histogram
+						connect(histogram.data(), &UMF::ComputeHistogram::histogramReady, this/*context*/,
+								[this, name](QVector<double> Bin, QVector<double> Count){
+									ui->MatchingChartView->plotHistogram(Bin, Count, name+"-Unknown Distances Histogram");
+								}, Qt::QueuedConnection);
+						histogram >> Test;
+					};
+					computeHistogram(*intraIndex, "Intra");
+					computeHistogram(*extraIndex, "Extra");
+					// Make the test start
+					Test->parallelExecution();
+				}, Qt::QueuedConnection);
+		MUExtract->parallelExecution();
+	}
 	// Display the progress dialog
 	progressDialog->exec();
 }
@@ -619,24 +644,14 @@ void GUI::Window::on_TabWidget_currentChanged(int index){
 }
 
 void GUI::Window::on_MLoadDatabaseButton_clicked(){
-	QString fileName = QFileDialog::getOpenFileName(this, "Choose origin file name", QDir::currentPath(), "Text files (*.txt)");
+	QString fileName = QFileDialog::getOpenFileName(this, "Choose origin file name", QDir::currentPath(), "Databases (*.cavadb);;All files (*)");
 	if (!fileName.isEmpty()){ // Check if the user pressed cancel
-		// Save the database to that file
-		QFile file(fileName);
-		if(file.open(QFile::ReadOnly)){
-			// Read two lines and settings
-			auto lineIntra = new GUI::DatabaseLine;
-			auto lineExtra = new GUI::DatabaseLine;
-			QSettings settings;
-			QDataStream istream(&file);
-			istream >> *lineIntra >> *lineExtra >> settings;
-			file.close();
-			// Show the curves on the chart
-			ui->MatchingChartView->updateViewWith(lineIntra);
-			ui->MatchingChartView->updateViewWith(lineExtra);
-			// Fill in the combo boxes
-			ui->MIntraCurveComboBox->addItems({lineIntra->name(), lineExtra->name()});
-			ui->MExtraCurveComboBox->addItems({lineIntra->name(), lineExtra->name()});
+		// Read the lines and the settings, with which the unknown voices are then processed
+		for(auto line: loadDatabase(fileName, true)){
+			// Show the curve on the chart and add it to the combo boxes
+			ui->MatchingChartView->updateViewWith(line);
+			ui->MIntraCurveComboBox->addItem(line->name());
+			ui->MExtraCurveComboBox->addItem(line->name());
 		}
 	}
 }
@@ -719,6 +734,7 @@ void GUI::Window::on_ResetParametersButton_clicked(){
 	settings.setValue("MinimumFrequency", double(500.));
 	settings.setValue("MaximumFrequency", double(3500.));
 	settings.setValue("MaximumSpectrumLeakage", double(10.));
+	settings.setValue("HopLength", int(0));
 	addEnumSetting(settings, UMF::ReduceChannels, "ChannelsOperation", average);
 	addEnumSetting(settings, UMF::ReduceChannels, "ChannelsArrangement", interleaved);
 	addEnumSetting(settings, UMF::Windowing, "WindowingFunction", hann);
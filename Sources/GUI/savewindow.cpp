@@ -27,7 +27,7 @@ SaveWindow::~SaveWindow()
 }
 
 void SaveWindow::on_browserPushButton_clicked(){
-	QString fileName = QFileDialog::getSaveFileName(this, "Choose destination file name", QDir::currentPath(), "Text files (*.txt)");
+	QString fileName = QFileDialog::getSaveFileName(this, "Choose destination file name", QDir::currentPath(), "Databases (*.cavadb)");
 	if (!fileName.isEmpty()) // Check if the user pressed cancel
 		ui->browserLineEdit->setText(fileName); // Share path with the line edit
 }
@@ -59,14 +59,41 @@ void SaveWindow::setLineWithName(GUI::DatabaseLine* line, QString name){
 }
 
 void SaveWindow::on_saveButton_clicked(){
+	auto intraLine = lines[ui->intraComboBox->currentText()];
+	auto extraLine = lines[ui->extraComboBox->currentText()];
+	// The files of the two lines are stored once when they are the same, as for the lines of a database just created
+	AA::DatabaseFile::Contents contents;
+	contents.Files = intraLine->getFiles();
+	const auto extraFiles = extraLine->getFiles();
+	const bool shared = std::equal(extraFiles.begin(), extraFiles.end(), contents.Files.begin(), contents.Files.end(),
+								   [](const auto& a, const auto& b){return a.Features == b.Features && a.Size == b.Size;});
+	if(!shared) contents.Files += extraFiles;
+	auto curve = [](const GUI::DatabaseLine* line, int first){
+		AA::DatabaseFile::Curve curve;
+		curve.Name = line->name();
+		curve.Model = line->getType() == GUI::DatabaseLine::Gaussian ? UMF::CurveNormalization::gauss : UMF::CurveNormalization::gaussExp;
+		curve.Color = line->color().rgba();
+		curve.Minimum = line->getMinimum();
+		curve.Maximum = line->getMaximum();
+		curve.Coefficients = line->getCoefficients();
+		curve.FirstFile = first;
+		curve.NumberFiles = line->getNumberFiles();
+		curve.HistogramMinimum = line->getHistogramMinimum();
+		curve.HistogramMaximum = line->getHistogramMaximum();
+		curve.BarStep = line->getBarStep();
+		curve.Counts = line->getCounts();
+		return curve;
+	};
+	contents.Curves << curve(intraLine, 0) << curve(extraLine, shared ? 0 : intraLine->getNumberFiles());
+	// Store the settings too, the extraction ones are needed to compare new files with the database
+	QSettings settings;
+	for(const auto& key: settings.allKeys())
+		contents.Parameters.insert(key, settings.value(key));
 	// Save the database to that file
-	QFile file(ui->browserLineEdit->text());
-	if(file.open(QFile::WriteOnly)){
-		QDataStream ostream(&file);
-		auto intraLine = lines[ui->intraComboBox->currentText()];
-		auto extraLine = lines[ui->extraComboBox->currentText()];
-		ostream << *intraLine << *extraLine << QSettings();
-		file.close();
+	QString error;
+	if(!AA::DatabaseFile::save(ui->browserLineEdit->text(), contents, &error)){
+		QMessageBox::critical(this, "Error", error);
+		return;
 	}
 	// Close the window
 	close();
@@ -0,0 +1,19 @@
+#include <UMF/ConcurrentHistogram.hpp>
+
+UMF::ConcurrentHistogram::ConcurrentHistogram(double minimum, double maximum, double step, int numberShards):
+shards(std::max(numberShards, 1)){
+	for (auto& shard: shards)
+		shard.histogram = HistogramAccumulator(minimum, maximum, step);
+}
+
+UMF::HistogramAccumulator UMF::ConcurrentHistogram::merged() const{
+	HistogramAccumulator histogram = shards.front().histogram;
+	for (std::size_t k = 1; k < shards.size(); ++k)
+		histogram += shards[k].histogram;
+	return histogram;
+}
+
+void UMF::ConcurrentHistogram::clear(){
+	for (auto& shard: shards)
+		shard.histogram.clear();
+}
@@ -1,25 +1,38 @@
 #include <UMF/CurveNormalization.hpp>
+#include <UMF/Evaluate1D.hpp>
 
 void UMF::CurveNormalization::run(){
-	// Create an evaluator instance
-	auto evaluator = UMF::EvaluateGaussExp::create();
-	evaluator->setCoefficients(getInCoefficients());
+	auto coeff = getInMoveCoefficients();
 	// Compute the function integral
+	const double value = integral(getModel(), coeff, getLeftExtremum(), getRightExtremum());
+	// Normalization
+	if(value != 0.0) coeff[0] /= value;
+	setOutCoefficients(std::move(coeff));
+}
+
+double UMF::CurveNormalization::integral(int model, const QVector<double>& C, double left, double right){
+	const double value = model == gauss ?
+		EvaluateGauss::integral(C.constData(), left, right) :
+		EvaluateGaussExp::integral(C.constData(), left, right);
+	return std::isnan(value) ? adaptiveIntegral(model, C, left, right) : value;
+}
+
+double UMF::CurveNormalization::adaptiveIntegral(int model, const QVector<double>& C, double left, double right){
+	// The model kernel is called on the single points required
+	struct Integrand {
+		Evaluate1D::BatchFuncType kernel;
+		const double* C;
+	} integrand = {model == gauss ? &EvaluateGauss::kernel : &EvaluateGaussExp::kernel, C.constData()};
 	auto func = [](double x, double xminusa, double bminusx, double &y, void *ptr){
-		auto evaluator = reinterpret_cast<UMF::EvaluateGaussExp*>(ptr);
-		evaluator->setInX({x});
-		evaluator->run();
-		y = evaluator->getOutMoveY().takeFirst();
+		const auto integrand = static_cast<const Integrand*>(ptr);
+		integrand->kernel(integrand->C, &x, 1, &y);
 	};
 	auto cast_func = static_cast<void (*)(double, double, double, double&, void*)>(func);
 	alglib::autogkstate state;
 	double value;
 	alglib::autogkreport report;
-	alglib::autogksmooth(getLeftExtremum(), getRightExtremum(), state);
-	alglib::autogkintegrate(state, cast_func, evaluator.data());
+	alglib::autogksmooth(left, right, state);
+	alglib::autogkintegrate(state, cast_func, &integrand);
 	alglib::autogkresults(state, value, report);
-	// Normalization
-	auto coeff = getInMoveCoefficients();
-	if(value != 0.0) coeff[0] /= value;
-	setOutCoefficients(std::move(coeff));
+	return value;
 }
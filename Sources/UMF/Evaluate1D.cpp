@@ -8,6 +8,12 @@ void UMF::Evaluate1D::run(){
 
 QVector<double> UMF::Evaluate1D::evaluate(QVector<double> C,
 										 QVector<double> X) {
+	// Evaluate the whole array at once if the model has a kernel
+	if (batch){
+		QVector<double> Y(X.size());
+		batch(C.constData(), X.constData(), X.size(), Y.data());
+		return Y;
+	}
 	alglib::real_1d_array cvec, xvec;
 	cvec.setcontent(C.size(), C.data());
 	QVector<double> Y;
@@ -33,6 +39,59 @@ void UMF::EvaluateGaussExp::init(){
 		const auto& tau = cc[3];
 		func = nu * alglib::normaldistribution(( x - mu ) / sigma) * std::exp(- x / tau);
 	};
+	gradient = [](const alglib::real_1d_array& cc,
+				  const alglib::real_1d_array& xx,
+				  double& func,
+				  alglib::real_1d_array& grad,
+				  void* ptr) {
+		const auto& x = xx[0];
+		const auto& nu = cc[0];
+		const auto& mu = cc[1];
+		const auto& sigma = cc[2];
+		const auto& tau = cc[3];
+		const double z = ( x - mu ) / sigma;
+		const double decay = std::exp(- x / tau);
+		const double cdf = alglib::normaldistribution(z);
+		// Derivative with respect to z, i.e. the normal density, times nu and the decay
+		const double density = nu * decay * 0.39894228040143267794 * std::exp(-0.5 * z * z);
+		func = nu * cdf * decay;
+		grad[0] = cdf * decay;
+		grad[1] = - density / sigma;
+		grad[2] = - density * z / sigma;
+		grad[3] = func * x / (tau * tau);
+	};
+	batch = &EvaluateGaussExp::kernel;
+}
+
+void UMF::EvaluateGaussExp::kernel(const double* C, const double* X, qint64 size, double* Y){
+	// Coefficients are copied, so that the compiler knows that Y does not overwrite them
+	const double nu = C[0], mu = C[1], sigma = C[2], tau = C[3];
+	for (qint64 k = 0; k < size; ++k){
+		const double x = X[k];
+		Y[k] = nu * FastMath::normalCDF(( x - mu ) / sigma) * FastMath::exp(- x / tau);
+	}
+}
+
+double UMF::EvaluateGaussExp::integral(const double* C, double left, double right){
+	const double nu = C[0], mu = C[1], sigma = C[2], tau = C[3];
+	// Integrating by parts, nu*tau*(K(left)-K(right)) with K(x) = exp(-x/tau)*Phi(z) + exp(s^2/2-mu/tau)*Q(z+s),
+	// z = (x-mu)/sigma, s = sigma/tau and Q = 1-Phi
+	auto primitive = [=](double x){
+		const double z = ( x - mu ) / sigma;
+		const double s = sigma / tau;
+		const double u = z + s;
+		// For u >= 0 the large factors of the second term cancel out with the ones of Q(u)
+		double tail;
+		if (u >= 0.0)
+			tail = 0.5 * FastMath::scaledErfc(u * 0.70710678118654752440) * std::exp(- 0.5 * z * z - x / tau);
+		else
+			tail = std::exp(0.5 * s * s - mu / tau) * FastMath::normalCDF(- u);
+		return std::exp(- x / tau) * FastMath::normalCDF(z) + tail;
+	};
+	const double K1 = primitive(left), K2 = primitive(right);
+	if (std::abs(K1 - K2) < 1e-3 * std::max(std::abs(K1), std::abs(K2)))
+		return std::numeric_limits<double>::quiet_NaN();
+	return nu * tau * (K1 - K2);
 }
 
 void UMF::EvaluateGauss::init(){
@@ -43,6 +102,39 @@ void UMF::EvaluateGauss::init(){
 		func = std::exp( - std::pow(x[0]-c[1], 2.0) / (2.0*c[2]*c[2]) );
 		func *= c[0];
 	};
+	gradient = [](const alglib::real_1d_array& c,
+				  const alglib::real_1d_array& x,
+				  double& func,
+				  alglib::real_1d_array& grad,
+				  void* ptr) {
+		const double d = x[0] - c[1];
+		const double variance = c[2] * c[2];
+		const double e = std::exp( - d * d / (2.0 * variance) );
+		func = c[0] * e;
+		grad[0] = e;
+		grad[1] = func * d / variance;
+		grad[2] = func * d * d / (variance * c[2]);
+		// The fitting has a fourth coefficient, unused by this model
+		for (alglib::ae_int_t k = 3; k < grad.length(); ++k) grad[k] = 0.0;
+	};
+	batch = &EvaluateGauss::kernel;
+}
+
+void UMF::EvaluateGauss::kernel(const double* C, const double* X, qint64 size, double* Y){
+	const double scale = C[0], mean = C[1], variance = 2.0*C[2]*C[2];
+	for (qint64 k = 0; k < size; ++k){
+		const double d = X[k] - mean;
+		Y[k] = scale * FastMath::exp( - d * d / variance );
+	}
+}
+
+double UMF::EvaluateGauss::integral(const double* C, double left, double right){
+	const double z1 = ( left - C[1] ) / C[2], z2 = ( right - C[1] ) / C[2];
+	// Difference of the upper tails on the right of the mean, where the ones of Phi would cancel out
+	const double area = 2.50662827463100050242 * C[0] * C[2];
+	if (z1 > 0.0)
+		return area * (FastMath::normalCDF(- z1) - FastMath::normalCDF(- z2));
+	return area * (FastMath::normalCDF(z2) - FastMath::normalCDF(z1));
 }
 
 void UMF::Fitting1D::run(){
@@ -68,13 +160,21 @@ void UMF::Fitting1D::run(){
 	double epsX = 1e-10;
 	const double diffStep = 0.001;
 	alglib::ae_int_t maxIters = 0;
-	// Initialize the algorithm
-	alglib::lsfitcreatef(xx, yy, c, diffStep, state);
+	// Initialize the algorithm, with the analytic gradient if the model has one (the numeric one
+	// costs a couple of evaluations per coefficient, and is less accurate on noisy histograms)
+	const auto gradient = evaluator->getGradientFunc();
+	if (gradient)
+		alglib::lsfitcreatefg(xx, yy, c, true, state);
+	else
+		alglib::lsfitcreatef(xx, yy, c, diffStep, state);
 	alglib::lsfitsetbc(state, "[0.0, 0.0, 0.0, 0.0]", "[+INF, +INF, +INF, +INF]");
 	alglib::lsfitsetcond(state, epsF, epsX, maxIters);
 	alglib::ae_int_t info;
 	// Perform fitting
-	alglib::lsfitfit(state, evaluator->getInternalFunc());
+	if (gradient)
+		alglib::lsfitfit(state, evaluator->getInternalFunc(), gradient);
+	else
+		alglib::lsfitfit(state, evaluator->getInternalFunc());
 	alglib::lsfitresults(state, info, c, report);
 	// Export results
 	QVector<double> C({c[0], c[1], c[2], c[3]});
@@ -84,6 +184,7 @@ void UMF::Fitting1D::run(){
 	auto [Left, Right] = std::minmax_element(X.begin(), X.end(), std::less<>{});
 	// Normalize the curve to unit integral (this should not be here)
 	auto normalizer = CurveNormalization::create();
+	normalizer->setModel(model);
 	normalizer->setLeftExtremum(*Left);
 	normalizer->setRightExtremum(*Right);
 	normalizer->setInCoefficients(C);
@@ -94,6 +195,7 @@ void UMF::Fitting1D::run(){
 
 void UMF::FittingGauss::init(){
 	evaluator = EvaluateGauss::create();
+	model = CurveNormalization::gauss;
 }
 
 void UMF::FittingGaussExp::init(){
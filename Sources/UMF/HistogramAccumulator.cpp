@@ -0,0 +1,59 @@
+#include <UMF/HistogramAccumulator.hpp>
+#include <algorithm>
+#include <cmath>
+
+UMF::HistogramAccumulator::HistogramAccumulator(double minimum, double maximum, double step):
+minimum(minimum),
+maximum(maximum),
+step(step){
+	// Without a valid range no value is binned
+	if (step > 0.0 && maximum >= minimum)
+		bins.resize(int(floor((maximum - minimum) / step)) + 1, 0);
+	else
+		this->maximum = minimum - 1.0;
+}
+
+UMF::HistogramAccumulator& UMF::HistogramAccumulator::operator+=(const HistogramAccumulator& other){
+	// Unused histograms (e.g. of threads that got no work) can be merged whatever their bins
+	if (other.total == 0) return *this;
+	if (total == 0 && bins.empty()) return *this = other;
+	for (std::size_t k = 0; k < bins.size() && k < other.bins.size(); ++k)
+		bins[k] += other.bins[k];
+	total += other.total;
+	largest = std::max(largest, other.largest);
+	return *this;
+}
+
+bool UMF::HistogramAccumulator::addCounts(const QVector<double>& counts){
+	if (counts.size() != getNumberBins()) return false;
+	for (int k = 0; k < counts.size(); ++k){
+		bins[k] += qint64(counts[k]);
+		total += qint64(counts[k]);
+	}
+	return true;
+}
+
+QVector<double> UMF::HistogramAccumulator::getCounts() const{
+	QVector<double> counts(getNumberBins());
+	std::copy(bins.begin(), bins.end(), counts.begin());
+	return counts;
+}
+
+void UMF::HistogramAccumulator::clear(){
+	std::fill(bins.begin(), bins.end(), 0);
+	total = 0;
+	largest = -std::numeric_limits<double>::infinity();
+}
+
+void UMF::HistogramAccumulator::getHistogram(QVector<double>& X, QVector<double>& Y, bool suppressZeroCount, bool cropToLargest) const{
+	int numberBins = getNumberBins();
+	if (cropToLargest)
+		numberBins = largest >= minimum ? std::min(numberBins, int(floor((std::min(largest, maximum) - minimum) / step)) + 1) : 0;
+	X.clear();
+	Y.clear();
+	for (int k = 0; k < numberBins; ++k){
+		if (suppressZeroCount && bins[k] == 0) continue;
+		X << minimum + step * (k + 0.5);
+		Y << double(bins[k]);
+	}
+}
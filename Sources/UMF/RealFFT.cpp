@@ -0,0 +1,233 @@
+#include <UMF/RealFFT.hpp>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <algorithm>
+#include <cmath>
+
+QSharedPointer<const UMF::RealFFT> UMF::RealFFT::plan(int size){
+	if (!supports(size)) return QSharedPointer<const RealFFT>();
+	// Only a handful of lengths is used by an application, so plans are never released
+	static QMutex mutex;
+	static QHash<int, QSharedPointer<const RealFFT>> plans;
+	QMutexLocker lock(&mutex);
+	auto& plan = plans[size];
+	if (!plan) plan = QSharedPointer<const RealFFT>(new RealFFT(size));
+	return plan;
+}
+
+UMF::RealFFT::RealFFT(int size): N(size){
+	const int M = N / 2;
+	int bits = 0;
+	while ((1 << bits) < M) ++bits;
+	reversed.resize(M);
+	for (int n = 0; n < M; ++n){
+		int r = 0;
+		for (int b = 0; b < bits; ++b) r |= ((n >> b) & 1) << (bits - 1 - b);
+		reversed[n] = r;
+	}
+	// Twiddle factors are computed directly rather than by recurrence, to keep full accuracy
+	stageRe.resize(std::max(M - 1, 1));
+	stageIm.resize(std::max(M - 1, 1));
+	for (int h = 1; h < M; h *= 2){
+		for (int j = 0; j < h; ++j){
+			stageRe[h-1+j] = cos(M_PI * j / h);
+			stageIm[h-1+j] = -sin(M_PI * j / h);
+		}
+	}
+	splitRe.resize(M/2 + 1);
+	splitIm.resize(M/2 + 1);
+	for (int k = 0; k <= M/2; ++k){
+		splitRe[k] = cos(2.0 * M_PI * k / N);
+		splitIm[k] = -sin(2.0 * M_PI * k / N);
+	}
+}
+
+void UMF::RealFFT::forward(const double* in, double* re, double* im) const{
+	const int M = N / 2;
+	// Pack the even and odd samples into a complex signal, in bit reversed order
+	const int* rev = reversed.constData();
+	for (int n = 0; n < M; ++n){
+		re[rev[n]] = in[2*n];
+		im[rev[n]] = in[2*n+1];
+	}
+	butterflies(re, im);
+	// Split pass: separate the spectra of the even (E) and odd (O) samples from the packed one (Z),
+	// then X[k] = E[k] + W^k O[k] and X[M-k] = conj(E[k] - W^k O[k]), processing k and M-k together
+	const double z0r = re[0], z0i = im[0];
+	re[0] = z0r + z0i; im[0] = 0.0;
+	re[M] = z0r - z0i; im[M] = 0.0;
+	for (int k = 1; k <= M/2; ++k){
+		const double ar = re[k], ai = im[k], br = re[M-k], bi = im[M-k];
+		// E = (A + conj(B))/2, O = (A - conj(B))/(2i)
+		const double er = 0.5 * (ar + br), ei = 0.5 * (ai - bi);
+		const double or_ = 0.5 * (ai + bi), oi = -0.5 * (ar - br);
+		const double tr = splitRe[k] * or_ - splitIm[k] * oi;
+		const double ti = splitRe[k] * oi + splitIm[k] * or_;
+		re[k] = er + tr; im[k] = ei + ti;
+		re[M-k] = er - tr; im[M-k] = -(ei - ti);
+	}
+}
+
+void UMF::RealFFT::butterflies(double* re, double* im) const{
+	const int M = N / 2;
+	// First two stages merged in radix-4 butterflies, whose twiddle factors are 1 and -i
+	if (M == 2){
+		const double ur = re[0], ui = im[0];
+		re[0] = ur + re[1]; im[0] = ui + im[1];
+		re[1] = ur - re[1]; im[1] = ui - im[1];
+	}
+	for (int i = 0; i + 3 < M; i += 4){
+		const double sr = re[i] + re[i+1], si = im[i] + im[i+1];
+		const double dr = re[i] - re[i+1], di = im[i] - im[i+1];
+		const double tr = re[i+2] + re[i+3], ti = im[i+2] + im[i+3];
+		const double qr = re[i+2] - re[i+3], qi = im[i+2] - im[i+3];
+		re[i] = sr + tr; im[i] = si + ti;
+		re[i+2] = sr - tr; im[i+2] = si - ti;
+		// -i (qr + i qi) = qi - i qr
+		re[i+1] = dr + qi; im[i+1] = di - qr;
+		re[i+3] = dr - qi; im[i+3] = di + qr;
+	}
+	// Other stages, h butterflies per block
+	for (int h = 4; h < M; h *= 2){
+		const double* __restrict wr = stageRe.constData() + h - 1;
+		const double* __restrict wi = stageIm.constData() + h - 1;
+		for (int i = 0; i < M; i += 2*h){
+			double* __restrict ar = re + i;
+			double* __restrict ai = im + i;
+			double* __restrict br = re + i + h;
+			double* __restrict bi = im + i + h;
+			for (int j = 0; j < h; ++j){
+				const double vr = br[j] * wr[j] - bi[j] * wi[j];
+				const double vi = br[j] * wi[j] + bi[j] * wr[j];
+				br[j] = ar[j] - vr; bi[j] = ai[j] - vi;
+				ar[j] += vr; ai[j] += vi;
+			}
+		}
+	}
+}
+
+void UMF::RealFFT::inverse(double* re, double* im, double* out) const{
+	const int M = N / 2;
+	// Merge pass, the inverse of the split one: Z[k] = E[k] + i O[k], with E[k] = (X[k] + conj(X[M-k]))/2
+	// and O[k] = conj(W^k) (X[k] - conj(X[M-k]))/2; Z is conjugated on the fly, since the inverse
+	// transform is computed as the conjugate of the forward transform of the conjugate
+	const double x0 = re[0], xM = re[M];
+	re[0] = 0.5 * (x0 + xM); im[0] = -0.5 * (x0 - xM);
+	for (int k = 1; k < M/2; ++k){
+		const double ar = re[k], ai = im[k], br = re[M-k], bi = im[M-k];
+		const double er = 0.5 * (ar + br), ei = 0.5 * (ai - bi);
+		const double dr = 0.5 * (ar - br), di = 0.5 * (ai + bi);
+		const double or_ = splitRe[k] * dr + splitIm[k] * di;
+		const double oi = splitRe[k] * di - splitIm[k] * dr;
+		re[k] = er - oi; im[k] = -(ei + or_);
+		re[M-k] = er + oi; im[M-k] = -(or_ - ei);
+	}
+	// Z[M/2] = conj(X[M/2]), so its conjugate is already in place
+	// Bit reversal permutation in place
+	const int* rev = reversed.constData();
+	for (int n = 0; n < M; ++n){
+		if (rev[n] > n){
+			std::swap(re[n], re[rev[n]]);
+			std::swap(im[n], im[rev[n]]);
+		}
+	}
+	butterflies(re, im);
+	// Unpack the even and odd samples, conjugating and normalizing
+	const double factor = 1.0 / M;
+	for (int n = 0; n < M; ++n){
+		out[2*n] = re[n] * factor;
+		out[2*n+1] = -im[n] * factor;
+	}
+}
+
+void UMF::RealFFT::power(const double* __restrict re, const double* __restrict im, int count, double factor, double* __restrict out){
+	for (int k = 0; k < count; ++k)
+		out[k] = (re[k] * re[k] + im[k] * im[k]) * factor;
+}
+
+void UMF::RealFFT::powerBatch(const double* in, int count, double factor, double* out, QVector<double>& workspace) const{
+	const int L = batchWidth;
+	const int M = N / 2;
+	// Interleaved layout: element n of record l of the group is at n*L+l
+	if (workspace.size() < 2 * (M+1) * L) workspace.resize(2 * (M+1) * L);
+	double* __restrict re = workspace.data();
+	double* __restrict im = re + (M+1) * L;
+	const int* rev = reversed.constData();
+	for (int group = 0; group < count; group += L){
+		const int lanes = std::min(L, count - group);
+		// Pack the records in bit reversed order; missing records of the last group are zeros
+		if (lanes < L) std::fill(re, re + 2 * (M+1) * L, 0.0);
+		for (int l = 0; l < lanes; ++l){
+			const double* x = in + qint64(group + l) * N;
+			for (int n = 0; n < M; ++n){
+				re[rev[n]*L+l] = x[2*n];
+				im[rev[n]*L+l] = x[2*n+1];
+			}
+		}
+		// First stage (or first two stages merged), as in forward
+		if (M == 2){
+			for (int l = 0; l < L; ++l){
+				const double ur = re[l], ui = im[l];
+				re[l] = ur + re[L+l]; im[l] = ui + im[L+l];
+				re[L+l] = ur - re[L+l]; im[L+l] = ui - im[L+l];
+			}
+		}
+		for (int i = 0; i + 3 < M; i += 4){
+			double* __restrict r = re + i*L;
+			double* __restrict m = im + i*L;
+			for (int l = 0; l < L; ++l){
+				const double sr = r[l] + r[L+l], si = m[l] + m[L+l];
+				const double dr = r[l] - r[L+l], di = m[l] - m[L+l];
+				const double tr = r[2*L+l] + r[3*L+l], ti = m[2*L+l] + m[3*L+l];
+				const double qr = r[2*L+l] - r[3*L+l], qi = m[2*L+l] - m[3*L+l];
+				r[l] = sr + tr; m[l] = si + ti;
+				r[2*L+l] = sr - tr; m[2*L+l] = si - ti;
+				r[L+l] = dr + qi; m[L+l] = di - qr;
+				r[3*L+l] = dr - qi; m[3*L+l] = di + qr;
+			}
+		}
+		// Other stages, the twiddle factor of each butterfly is shared by the lanes
+		for (int h = 4; h < M; h *= 2){
+			for (int i = 0; i < M; i += 2*h){
+				for (int j = 0; j < h; ++j){
+					const double wr = stageRe[h-1+j], wi = stageIm[h-1+j];
+					double* __restrict ar = re + (i+j)*L;
+					double* __restrict ai = im + (i+j)*L;
+					double* __restrict br = re + (i+j+h)*L;
+					double* __restrict bi = im + (i+j+h)*L;
+					for (int l = 0; l < L; ++l){
+						const double vr = br[l] * wr - bi[l] * wi;
+						const double vi = br[l] * wi + bi[l] * wr;
+						br[l] = ar[l] - vr; bi[l] = ai[l] - vi;
+						ar[l] += vr; ai[l] += vi;
+					}
+				}
+			}
+		}
+		// Split pass and power spectra, written record by record
+		for (int l = 0; l < lanes; ++l){
+			double* spectrum = out + qint64(group + l) * (M+1);
+			spectrum[0] = (re[l] + im[l]) * (re[l] + im[l]) * factor;
+			spectrum[M] = (re[l] - im[l]) * (re[l] - im[l]) * factor;
+		}
+		for (int k = 1; k <= M/2; ++k){
+			const double wr = splitRe[k], wi = splitIm[k];
+			double xr[L], xi[L], yr[L], yi[L];
+			for (int l = 0; l < L; ++l){
+				const double ar = re[k*L+l], ai = im[k*L+l], br = re[(M-k)*L+l], bi = im[(M-k)*L+l];
+				const double er = 0.5 * (ar + br), ei = 0.5 * (ai - bi);
+				const double or_ = 0.5 * (ai + bi), oi = -0.5 * (ar - br);
+				const double tr = wr * or_ - wi * oi;
+				const double ti = wr * oi + wi * or_;
+				xr[l] = er + tr; xi[l] = ei + ti;
+				yr[l] = er - tr; yi[l] = ti - ei;
+			}
+			for (int l = 0; l < lanes; ++l){
+				double* spectrum = out + qint64(group + l) * (M+1);
+				spectrum[k] = (xr[l] * xr[l] + xi[l] * xi[l]) * factor;
+				spectrum[M-k] = (yr[l] * yr[l] + yi[l] * yi[l]) * factor;
+			}
+		}
+	}
+}
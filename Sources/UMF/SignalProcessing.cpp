@@ -6,25 +6,29 @@ void UMF::ReduceChannels::run(){
 	auto signalLength = getInSignal().size()/getNumberChannels();
 	if (signalLength * getNumberChannels() != getInSignal().size())
 		qInfo() << "Some sample will be discarded reducing channels";
-	QVector<double> out;
-	out.reserve(signalLength);
-	double factor = 1.0 / double(getNumberChannels());
+	QVector<double> out(signalLength);
+	apply(getInSignal().constData(), getInSignal().size(), out.data());
+	setOutSignal(out);
+}
+
+void UMF::ReduceChannels::apply(const double* in, int inputSize, double* out){
+	const int numberChannels = getNumberChannels();
+	const int signalLength = inputSize/numberChannels;
+	double factor = 1.0 / double(numberChannels);
 	switch (getChannelsArrangement()) {
 		case interleaved:
-			for(auto c1 = getInSignal().constBegin(); c1 != getInSignal().constEnd(); c1 += getNumberChannels())
-				out << std::reduce(c1, c1+getNumberChannels(), 0.0, std::plus<>{}) * factor;
+			for(auto c1 = in; c1 != in + signalLength*numberChannels; c1 += numberChannels)
+				*out++ = std::reduce(c1, c1+numberChannels, 0.0, std::plus<>{}) * factor;
 			break;
 		case separated:
-			for (auto s = getInSignal().constBegin(); s != getInSignal().constBegin()+signalLength; ++s) {
+			for (auto s = in; s != in+signalLength; ++s) {
 				double sum = 0.0;
-				for(auto c = s; c != getInSignal().constEnd(); c += signalLength)
+				for(auto c = s; c < in + inputSize; c += signalLength)
 					sum += *c;
-				out << sum * factor;
+				*out++ = sum * factor;
 			}
 			break;
 	}
-	out.squeeze();
-	setOutSignal(out);
 }
 
 void UMF::Windowing::run(){
@@ -45,15 +49,19 @@ void UMF::Windowing::init(){
 	int k = 0;
 	switch (getType()) {
 		case hann:
-			double arg = TMath::TwoPi() / (getLength() - 1);
+			double arg = 2.0 * M_PI / (getLength() - 1);
 			std::generate_n(std::back_inserter(window), getLength(), [&arg, &k](){
-				return 0.5 - 0.5 * TMath::Cos(arg*(k++));
+				return 0.5 - 0.5 * cos(arg*(k++));
 			});
 			break;
 	}
 	window.squeeze();
 }
 
+void UMF::Windowing::apply(double* signal) const{
+	std::transform(signal, signal+window.size(), window.constBegin(), signal, std::multiplies<>());
+}
+
 void UMF::ArrayPad::run(){
 	// Checks
 	if (getBorderType() != constant && getInSignal().size() <= getRadius()){
@@ -61,19 +69,31 @@ void UMF::ArrayPad::run(){
 		setBorderType(constant);
 	}
 	// Construct an array with 2*m more element than the input one
-	// Fill the central part with the input array
-	auto inputSize = getInSignal().size();
-	auto output = getInMoveSignal();
-	output.resize(inputSize + 2 * getRadius());
-	std::move_backward(output.begin(), output.begin()+inputSize, output.end()-getRadius());
+	auto input = getInMoveSignal();
+	QVector<double> output(input.size() + 2 * getRadius());
 	// Clear input signal
 	setInSignal(QVector<double>());
 	// Fill the output array with correct values
-	auto left_begin = output.begin();
-	auto left_end = output.begin()+getRadius();
-	auto right_begin = output.end()-getRadius();
-	auto right_end = output.end();
-	switch (getBorderType()) {
+	if (!pad(input.constData(), input.size(), getRadius(), getBorderType(), output.data())){
+		abort("Interpolation mode not recognized");
+		return;
+	}
+	setOutSignal(output);
+}
+
+bool UMF::ArrayPad::pad(const double* in,
+						int size,
+						int radius,
+						int borderType,
+						double* out){
+	// Fill the central part with the input array
+	std::copy(in, in+size, out+radius);
+	// Fill the borders
+	auto left_begin = out;
+	auto left_end = out+radius;
+	auto right_begin = out+radius+size;
+	auto right_end = right_begin+radius;
+	switch (borderType) {
 		case constant:
 			std::fill(left_begin, left_end, 0);
 			std::fill(right_begin, right_end, 0);
@@ -83,26 +103,44 @@ void UMF::ArrayPad::run(){
 			std::fill(right_begin, right_end, *(right_begin-1));
 			break;
 		case reflect:
-			std::copy(left_end, left_end+getRadius(), left_begin);
+			std::copy(left_end, left_end+radius, left_begin);
 			std::reverse(left_begin, left_end);
-			std::copy(right_begin-getRadius(), right_begin, right_begin);
+			std::copy(right_begin-radius, right_begin, right_begin);
 			std::reverse(right_begin, right_end);
 			break;
 		case wrap:
-			std::copy(right_begin-getRadius(), right_begin, left_begin);
-			std::copy(left_end, left_end+getRadius(), right_begin);
+			std::copy(right_begin-radius, right_begin, left_begin);
+			std::copy(left_end, left_end+radius, right_begin);
 			break;
 		case reflect_101:
-			std::copy(left_end+1, left_end+getRadius()+1, left_begin);
+			std::copy(left_end+1, left_end+radius+1, left_begin);
 			std::reverse(left_begin, left_end);
-			std::copy(right_begin-getRadius()-1, right_begin-1, right_begin);
+			std::copy(right_begin-radius-1, right_begin-1, right_begin);
 			std::reverse(right_begin, right_end);
 			break;
 		default:
-			abort("Interpolation mode not recognized");
-			break;
+			return false;
+	}
+	return true;
+}
+
+double UMF::ArrayPad::extrapolate(const double* in,
+								  int size,
+								  int pos,
+								  int borderType){
+	if (pos >= 0 && pos < size) return in[pos];
+	switch (borderType) {
+		case replicate:
+			return pos < 0 ? in[0] : in[size-1];
+		case reflect:
+			return pos < 0 ? in[-pos-1] : in[2*size-pos-1];
+		case wrap:
+			return pos < 0 ? in[size+pos] : in[pos-size];
+		case reflect_101:
+			return pos < 0 ? in[-pos] : in[2*size-pos-2];
+		default:
+			return 0.0;
 	}
-	setOutSignal(output);
 }
 
 int UMF::ArrayPad::borderInterpolate(const int& pos,
@@ -140,32 +178,117 @@ void UMF::GaussianFilter::run(){
 		abort("Input signal not provided or empty");
 		return;
 	}
-	auto inputSize = getInSignal().size();
 	if (kernel.is_empty()) {
 		abort("Kernel not initialized");
 		return;
 	}
-	// Padding of input signal
-	auto pad = ArrayPad::create({
-		{"Radius", QVariant::fromValue(getRadius())},
-		{"BorderType", QVariant::fromValue((int)getBorderType())},
-		{"Signal", QVariant::fromValue(getInSignal())}
-	});
-	pad->run();
-	auto padded = pad->getOutMoveSignal();
-	// Convolution with kernel
-	QVector<double> filtered(padded.size());
-	vec _filtered(filtered.data(), filtered.size(), false, true);
-	_filtered = conv(vec(padded.data(), padded.size(), false, true), kernel, "same");
-	// Take the central part only
-	auto begin = filtered.begin()+getRadius();
-	auto end = begin+inputSize;
-	std::move(begin, end, filtered.begin()); // shift to the left
-	filtered.resize(inputSize);
+	// Filter the input signal
+	QVector<double> filtered(getInSignal().size());
+	apply(getInSignal().constData(), getInSignal().size(), filtered.data());
 	setOutSignal(std::move(filtered));
 	setInSignal(QVector<double>());
 }
 
+void UMF::GaussianFilter::apply(const double* in, int size, double* out){
+	const int radius = getRadius();
+	int borderType = getBorderType();
+	if (borderType != ArrayPad::constant && size <= radius){
+		qInfo() << "Signal length insufficient for selected border, fall back to constant case";
+		borderType = ArrayPad::constant;
+	}
+	if (radius >= fftRadius){
+		convolveFFT(in, size, borderType, out);
+		return;
+	}
+	if (size <= 2 * radius){
+		// Short signal, just pad it
+		padded.resize(size + 2 * radius);
+		ArrayPad::pad(in, size, radius, borderType, padded.data());
+		convolve(padded.constData(), size, out);
+		return;
+	}
+	// Left border: the virtual samples in [-radius, 0) followed by the first 2*radius ones
+	edge.resize(3 * radius);
+	for (int t = 0; t < 3 * radius; ++t)
+		edge[t] = ArrayPad::extrapolate(in, size, t - radius, borderType);
+	convolve(edge.constData(), radius, out);
+	// Inner samples, straight from the input
+	convolve(in, size - 2 * radius, out + radius);
+	// Right border: the last 2*radius samples followed by the virtual ones in [size, size+radius)
+	for (int t = 0; t < 3 * radius; ++t)
+		edge[t] = ArrayPad::extrapolate(in, size, size - 2 * radius + t, borderType);
+	convolve(edge.constData(), radius, out + size - radius);
+}
+
+void UMF::GaussianFilter::convolve(const double* __restrict x, int count, double* __restrict out) const{
+	// The products are accumulated in the same order as Armadillo's conv(..., "same"),
+	// two partial sums per output (even and odd taps), so that the result matches the one
+	// obtained with it. Blocks of outputs are computed together, the loops over the block
+	// having independent iterations that the compiler maps onto SIMD lanes.
+	const double* h = kernel.memptr();
+	const int taps = kernel.n_elem;
+	const int block = 8;
+	int n = 0;
+	for (; n + block <= count; n += block) {
+		double val1[block] = {0.0}, val2[block] = {0.0};
+		const double* xn = x + n;
+		int i, j;
+		for (i = 0, j = 1; j < taps; i += 2, j += 2) {
+			for (int b = 0; b < block; ++b) {
+				val1[b] += h[i] * xn[b+i];
+				val2[b] += h[j] * xn[b+j];
+			}
+		}
+		if (i < taps)
+			for (int b = 0; b < block; ++b) val1[b] += h[i] * xn[b+i];
+		for (int b = 0; b < block; ++b) out[n+b] = val1[b] + val2[b];
+	}
+	for (; n < count; ++n) {
+		double val1 = 0.0, val2 = 0.0;
+		const double* xn = x + n;
+		int i, j;
+		for (i = 0, j = 1; j < taps; i += 2, j += 2) {
+			val1 += h[i] * xn[i];
+			val2 += h[j] * xn[j];
+		}
+		if (i < taps) val1 += h[i] * xn[i];
+		out[n] = val1 + val2;
+	}
+}
+
+void UMF::GaussianFilter::convolveFFT(const double* in, int size, int borderType, double* out){
+	const int radius = getRadius();
+	// The padded signal is followed by zeros up to a power of two, so that the circular
+	// convolution does not wrap around
+	int length = 4;
+	while (length < size + 2 * radius) length *= 2;
+	const int halfLength = length / 2 + 1;
+	if (!fft || fft->size() != length){
+		fft = RealFFT::plan(length);
+		// The kernel is centered on the first sample, wrapping around: being symmetric,
+		// its spectrum is real
+		padded.fill(0.0, length);
+		const double* h = kernel.memptr();
+		for (int k = 0; k <= 2 * radius; ++k)
+			padded[(k - radius + length) % length] = h[k];
+		kernelSpectrum.resize(halfLength);
+		dftRe.resize(halfLength);
+		dftIm.resize(halfLength);
+		fft->forward(padded.constData(), kernelSpectrum.data(), dftIm.data());
+	}
+	padded.resize(length);
+	ArrayPad::pad(in, size, radius, borderType, padded.data());
+	std::fill(padded.begin() + size + 2 * radius, padded.end(), 0.0);
+	fft->forward(padded.constData(), dftRe.data(), dftIm.data());
+	for (int k = 0; k < halfLength; ++k){
+		dftRe[k] *= kernelSpectrum[k];
+		dftIm[k] *= kernelSpectrum[k];
+	}
+	fft->inverse(dftRe.data(), dftIm.data(), padded.data());
+	// The output n is centered on the padded sample n+radius
+	std::copy(padded.constBegin() + radius, padded.constBegin() + radius + size, out);
+}
+
 void UMF::GaussianFilter::init(){
 	QAlgorithm::init();
 	qRegisterMetaType<UMF::ArrayPad::border_type>();
@@ -173,43 +296,241 @@ void UMF::GaussianFilter::init(){
 	const auto& m = getRadius();
 	kernel = exp( - square(linspace(0, 2*m, 2*m+1) - m) / double(m*m) * 2.0 );
 	kernel = normalise(kernel, 1/*1-norm*/);
+	fft.clear();
 }
 
 void UMF::SpectrumMagnitude::run(){
-	// Move the input signal to local scope
-	auto rvSignal = getInMoveSignal();
-	// Link the input signal to an alglib array
-	alglib::real_1d_array signal;
-	signal.setcontent(rvSignal.size(), rvSignal.data());
+	const int count = getNumberRecords();
+	if (count < 1 || getInSignal().size() % count != 0){
+		abort("Input signal size (" + QLocale().toString(getInSignal().size()) + ") must be a multiple of the number of records (" + QLocale().toString(count) + ")");
+		return;
+	}
+	const int size = getInSignal().size() / count;
+	QVector<double> spectrum(count * (size/2+1));
+	applyBatch(getInSignal().constData(), size, count, spectrum.data());
+	setInSignal(QVector<double>());
+	setOutSignal(std::move(spectrum));
+}
+
+void UMF::SpectrumMagnitude::apply(const double* in, int size, double* out){
+	int halfSize = size/2+1;
+	double normFactor = 1.0/size;
+#ifndef UMF_FFT_ALGLIB
+	if (RealFFT::supports(size)) {
+		// Get the plan only when the size changes
+		if (!fft || fft->size() != size) fft = RealFFT::plan(size);
+		dftRe.resize(halfSize);
+		dftIm.resize(halfSize);
+		fft->forward(in, dftRe.data(), dftIm.data());
+		RealFFT::power(dftRe.constData(), dftIm.constData(), halfSize, normFactor, out);
+		return;
+	}
+#endif
+	// Copy the input signal to the alglib array, allocated only when the size changes
+	if (signal.length() != size) signal.setlength(size);
+	std::copy(in, in+size, signal.getcontent());
 	// Compute the FFT
-	alglib::complex_1d_array dft;
 	alglib::fftr1d(signal, dft);
 	// Compute the spectrum
-	int halfSize = rvSignal.size()/2+1;
-	double normFactor = 1.0/rvSignal.size();
-	rvSignal.resize(halfSize);
 	for(int k = 0; k < halfSize; ++k){
-		rvSignal[k] = (dft[k].x*dft[k].x + dft[k].y*dft[k].y) * normFactor;
+		out[k] = (dft[k].x*dft[k].x + dft[k].y*dft[k].y) * normFactor;
 	}
-	setOutSignal(std::move(rvSignal));
+}
+
+void UMF::SpectrumMagnitude::applyBatch(const double* in, int size, int count, double* out){
+#ifndef UMF_FFT_ALGLIB
+	if (count > 1 && RealFFT::supports(size)) {
+		if (!fft || fft->size() != size) fft = RealFFT::plan(size);
+		fft->powerBatch(in, count, 1.0/size, out, workspace);
+		return;
+	}
+#endif
+	for (int k = 0; k < count; ++k)
+		apply(in + qint64(k) * size, size, out + qint64(k) * (size/2+1));
 }
 
 void UMF::SpectrumRemoveBackground::run(){
-	QVector<double> out;
-	out.reserve(getInSignal().size());
-	std::copy(getInSignal().constBegin(), getInSignal().constEnd(), std::back_inserter(out));
-	auto error = TSpectrum().Background(out.data(), out.size(),
-										getNumberIterations(), getDirection(), getFilterOrder(),
-										getSmoothing(), getSmoothWindow(), getCompton());
-	if (error){
+	QVector<double> out(getInSignal().size());
+	if (auto error = apply(getInSignal().constData(), getInSignal().size(), out.data()); error){
 		abort(QString(error));
 		return;
 	}
-	std::transform(getInSignal().constBegin(), getInSignal().constEnd(), out.constBegin(), out.begin(),
-				   [](const auto& signal, const auto& background){ return signal-background;});
 	setOutSignal(out);
 }
 
+const char* UMF::SpectrumRemoveBackground::apply(const double* in, int size, double* out){
+	// Estimate the background in place on the output buffer
+	if (auto error = background(in, size, out); error) return error;
+	// Subtract the background from the input signal
+	std::transform(in, in+size, out, out,
+				   [](const auto& signal, const auto& background){ return signal-background;});
+	return Q_NULLPTR;
+}
+
+namespace {
+	/** Clipping step without smoothing: y[j] = min(x[j], estimates from x[j-i], ..., x[j+i]) for j in [i, size-i).
+	 The estimates are the ones of TSpectrum::Background, with the same order of the operations,
+	 to get the same values; the order of the filter is a template argument so that the loop has no branch.
+	 */
+	template <int order>
+	void clip(const double* __restrict x, double* __restrict y, int size, int i){
+		const int k2 = i / 2, k3 = i / 3, k4 = i / 4;
+		for (int j = i; j < size - i; ++j){
+			double b = (x[j - i] + x[j + i]) / 2.0;
+			if constexpr (order >= 8){
+				double e = 0;
+				e -= x[j - 4 * k4] / 70;
+				e += 8 * x[j - 3 * k4] / 70;
+				e -= 28 * x[j - 2 * k4] / 70;
+				e += 56 * x[j - k4] / 70;
+				e += 56 * x[j + k4] / 70;
+				e -= 28 * x[j + 2 * k4] / 70;
+				e += 8 * x[j + 3 * k4] / 70;
+				e -= x[j + 4 * k4] / 70;
+				b = std::max(b, e);
+			}
+			if constexpr (order >= 6){
+				double d = 0;
+				d += x[j - 3 * k3] / 20;
+				d -= 6 * x[j - 2 * k3] / 20;
+				d += 15 * x[j - k3] / 20;
+				d += 15 * x[j + k3] / 20;
+				d -= 6 * x[j + 2 * k3] / 20;
+				d += x[j + 3 * k3] / 20;
+				b = std::max(b, d);
+			}
+			if constexpr (order >= 4){
+				double c = 0;
+				c -= x[j - 2 * k2] / 6;
+				c += 4 * x[j - k2] / 6;
+				c += 4 * x[j + k2] / 6;
+				c -= x[j + 2 * k2] / 6;
+				b = std::max(b, c);
+			}
+			y[j] = std::min(x[j], b);
+		}
+	}
+
+	/** Clipping step with smoothing: the bins are replaced by averages on windows of 2*bw+1 bins
+	 (truncated at the borders), and the output is the clipped estimate if lower than the bin,
+	 otherwise the average around the bin.
+	 At orders 6 and 8 the averages are combined with the symmetric coefficients of the unsmoothed
+	 filter, while TSpectrum::Background uses coefficients that are not symmetric around the bin:
+	 with these settings the background differs from the one of ROOT.
+	 */
+	void clipSmoothed(const double* x, double* y, int size, int i, int order, int bw){
+		auto average = [&](int center){
+			double sum = 0, count = 0;
+			for (int w = center - bw; w <= center + bw; w++){
+				if (w >= 0 && w < size){
+					sum += x[w];
+					count += 1;
+				}
+			}
+			return sum / count;
+		};
+		const int k2 = i / 2, k3 = i / 3, k4 = i / 4;
+		for (int j = i; j < size - i; ++j){
+			const double a = x[j];
+			const double av = average(j);
+			double b = (average(j - i) + average(j + i)) / 2;
+			if (order >= 4){
+				const double b4 = (-average(j - 2 * k2) + 4 * average(j - k2) + 4 * average(j + k2) - average(j + 2 * k2)) / 6;
+				double b6 = b4, b8 = b4;
+				if (order >= 6)
+					b6 = (average(j - 3 * k3) - 6 * average(j - 2 * k3) + 15 * average(j - k3)
+						  + 15 * average(j + k3) - 6 * average(j + 2 * k3) + average(j + 3 * k3)) / 20;
+				if (order >= 8)
+					b8 = (-average(j - 4 * k4) + 8 * average(j - 3 * k4) - 28 * average(j - 2 * k4) + 56 * average(j - k4)
+						  + 56 * average(j + k4) - 28 * average(j + 2 * k4) + 8 * average(j + 3 * k4) - average(j + 4 * k4)) / 70;
+				b = std::max(b, b8);
+				b = std::max(b, b6);
+				b = std::max(b, b4);
+			}
+			y[j] = b < a ? b : av;
+		}
+	}
+}
+
+const char* UMF::SpectrumRemoveBackground::background(const double* in, int size, double* out){
+	const int iterations = getNumberIterations();
+	const int direction = getDirection();
+	const int smoothWindow = getSmoothWindow();
+	// Same checks (and messages) of TSpectrum
+	if (size <= 0)
+		return "Wrong Parameters";
+	if (iterations < 1)
+		return "Width of Clipping Window Must Be Positive";
+	if (size < 2 * iterations + 1)
+		return "Too Large Clipping Window";
+	if (getSmoothing() && (smoothWindow < kBackSmoothing3 || smoothWindow > kBackSmoothing15 || smoothWindow % 2 == 0))
+		return "Incorrect width of smoothing window";
+	if (direction != kBackIncreasingWindow && direction != kBackDecreasingWindow)
+		return "Incorrect direction of the clipping window";
+	if (getFilterOrder() < kBackOrder2 || getFilterOrder() > kBackOrder8)
+		return "Incorrect order of the clipping filter";
+	const int order = 2 * (getFilterOrder() + 1);
+	if (workspace.size() < 2 * size) workspace.resize(2 * size);
+	// Each iteration clips the current estimate (x) into the next one (y), then they are swapped;
+	// the bins out of the clipping range are just copied, so the estimate ends up in out
+	double* x = out;
+	double* y = workspace.data();
+	std::copy(in, in+size, x);
+	const int step = direction == kBackIncreasingWindow ? 1 : -1;
+	for (int i = direction == kBackIncreasingWindow ? 1 : iterations; i >= 1 && i <= iterations; i += step){
+		if (getSmoothing())
+			clipSmoothed(x, y, size, i, order, (smoothWindow - 1) / 2);
+		else switch (order){
+			case 2: clip<2>(x, y, size, i); break;
+			case 4: clip<4>(x, y, size, i); break;
+			case 6: clip<6>(x, y, size, i); break;
+			default: clip<8>(x, y, size, i); break;
+		}
+		std::copy(x, x + i, y);
+		std::copy(x + size - i, x + size, y + size - i);
+		std::swap(x, y);
+	}
+	if (x != out) std::copy(x, x + size, out);
+	// Estimate the Compton edges between the bins where the spectrum departs from the background
+	// (reading the clipped background from the workspace, while the edges are written on the output)
+	if (getCompton()){
+		const double* clipped = workspace.data() + size;
+		std::copy(out, out + size, workspace.data() + size);
+		for (int i = 0, j = 0, b2 = 0; i < size; i++){
+			j = i;
+			if (std::abs(clipped[i] - in[i]) >= 1){
+				const int b1 = std::max(i - 1, 0);
+				double yb1 = clipped[b1];
+				// Look for the next bin where the spectrum joins the background
+				for (b2 = b1 + 1; b2 < size; b2++){
+					if (std::abs(clipped[b2] - in[b2]) < 1){
+						b2++;
+						break;
+					}
+				}
+				if (b2 == size)
+					b2 -= 1;
+				const double yb2 = clipped[b2];
+				if (yb1 <= 0)
+					yb1 = 1;
+				double c = 0;
+				for (j = b1; j <= b2; j++)
+					c = c + in[j] - yb1;
+				if (c > 1){
+					c = (yb2 - yb1) / c;
+					double d = 0;
+					for (j = b1; j <= b2; j++){
+						d = d + in[j] - yb1;
+						out[j] = c * d + yb1;
+					}
+				}
+			}
+			i = j;
+		}
+	}
+	return Q_NULLPTR;
+}
+
 void UMF::SpectrumRemoveBackground::init(){
 	QAlgorithm::init();
 	qRegisterMetaType<UMF::SpectrumRemoveBackground::filterOrder>();